@@ -0,0 +1,111 @@
+#ifndef ASYNC_CENSUS_WRITER_H
+#define ASYNC_CENSUS_WRITER_H
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "CensusFile.h"
+#include "emp/base/Ptr.hpp"
+
+/**
+ * Moves census output off the simulation thread. The update loop pushes rows
+ * into a single-producer/single-consumer ring buffer and a dedicated writer
+ * thread drains everything that has accumulated in one batch, so slow storage
+ * only stalls the simulation if the ring fills up.
+ */
+class AsyncCensusWriter : public CensusOutput {
+  static constexpr size_t CAPACITY = 4096;
+  // How long the writer sleeps when the ring is empty; rows pile up meanwhile
+  static constexpr std::chrono::milliseconds IDLE_WAIT{2};
+
+  emp::Ptr<CensusOutput> file;
+  std::vector<CensusRow> ring;
+  // head is only written by the producer and tail only by the writer thread;
+  // both count rows ever pushed/popped, so head - tail is the fill level
+  std::atomic<size_t> head{0};
+  std::atomic<size_t> tail{0};
+  std::atomic<bool> stopping{false};
+  std::atomic<bool> flush_requested{false};
+  std::thread writer;
+
+  /**
+   * Input: None
+   *
+   * Output: None
+   *
+   * Purpose: Runs on the writer thread, draining the ring in batches until
+   * the writer is destroyed.
+   */
+  void WriterLoop() {
+    while (true) {
+      const bool last_pass = stopping.load(std::memory_order_acquire);
+      // Checked before reading head so rows queued ahead of a flush request are included
+      const bool flush = flush_requested.exchange(false, std::memory_order_acq_rel);
+      size_t read = tail.load(std::memory_order_relaxed);
+      const size_t available = head.load(std::memory_order_acquire);
+      for (; read != available; read++) {
+        file->Write(ring[read % CAPACITY]);
+      }
+      tail.store(read, std::memory_order_release);
+      if (flush) {
+        file->Flush();
+      }
+      if (last_pass) {
+        break;
+      }
+      std::this_thread::sleep_for(IDLE_WAIT);
+    }
+    file->Flush();
+  }
+
+public:
+  /**
+   * Takes ownership of the output the rows are written to.
+   */
+  explicit AsyncCensusWriter(emp::Ptr<CensusOutput> _file) : file(_file), ring(CAPACITY) {
+    writer = std::thread([this] { WriterLoop(); });
+  }
+
+  /**
+   * Writes any rows still in the ring before closing the output.
+   */
+  ~AsyncCensusWriter() override {
+    stopping.store(true, std::memory_order_release);
+    writer.join();
+    file.Delete();
+  }
+
+  AsyncCensusWriter(const AsyncCensusWriter &) = delete;
+  AsyncCensusWriter &operator=(const AsyncCensusWriter &) = delete;
+
+  /**
+   * Input: A census row
+   *
+   * Output: None
+   *
+   * Purpose: Queues the row for the writer thread. If the writer has fallen a
+   * full ring behind, waits for it to catch up rather than dropping data.
+   */
+  void Write(const CensusRow &row) override {
+    const size_t write = head.load(std::memory_order_relaxed);
+    while (write - tail.load(std::memory_order_acquire) == CAPACITY) {
+      std::this_thread::yield();
+    }
+    ring[write % CAPACITY] = row;
+    head.store(write + 1, std::memory_order_release);
+  }
+
+  /**
+   * Input: None
+   *
+   * Output: None
+   *
+   * Purpose: Asks the writer thread to flush once it has written the rows
+   * queued so far. Does not wait for it.
+   */
+  void Flush() override { flush_requested.store(true, std::memory_order_release); }
+};
+
+#endif
@@ -1,3 +1,12 @@
+#include <algorithm>
+#include <cstring>
+#include <iomanip>
+#include <map>
+#include <sstream>
+#include <string>
+
+#include "Checkpoint.h"
+#include "GenomeStore.h"
 #include "Instructions.h"
 #include "sgpl/algorithm/execute_cpu_n_cycles.hpp"
 #include "sgpl/hardware/Cpu.hpp"
@@ -6,11 +15,99 @@
 
 /**
  * Represents the virtual CPU and the program genome for an organism in the SGP
- * mode.
+ * mode. Spec selects the instruction set (NandSpec or NandXorSpec).
  */
+template <typename Spec>
 class CPU {
+  using genome_t = typename GenomeStore<Spec>::Handle;
+
+  // Mutation rate per instruction for offspring
+  static constexpr double MUTATION_RATE = 0.02;
+
   sgpl::Cpu<Spec> cpu;
-  sgpl::Program<Spec> program;
+  // Shared with every other organism that has the same program
+  genome_t genome;
+
+  using registers_t = decltype(sgpl::Core<Spec>::registers);
+
+  // Set once the CPU provably can never execute another IO or successful
+  // Reproduce, so running it further has no effect on the simulation
+  bool dormant = false;
+
+  /**
+   * The execution state recorded at the end of some step, for spotting a CPU
+   * that has come back to it without acting in between. Snapshots are retaken
+   * at doubling intervals, so a loop of any length is eventually caught.
+   */
+  struct LoopCheck {
+    bool valid = false;
+    uint64_t program_counter = 0;
+    uint64_t local_anchor_idx = LAUNCH_LOCAL_ANCHORS;
+    registers_t registers{};
+    uint32_t actions = 0;
+    // Steps since the snapshot, and how many to take before the next one
+    uint32_t steps = 0;
+    uint32_t interval = 1;
+  } loop;
+
+  /**
+   * Input: None
+   *
+   * Output: None
+   *
+   * Purpose: Starts dormancy detection over after the genome or execution
+   * state is replaced. A genome without any action instruction is dormant
+   * from the start.
+   */
+  void ResetDormancy() {
+    dormant = !genome->can_act;
+    loop = LoopCheck{};
+  }
+
+  /**
+   * Input: None
+   *
+   * Output: None
+   *
+   * Purpose: Checks, after a step, whether the CPU is looping without acting.
+   * A core's execution state is its program counter, its registers, and its
+   * local jump table, which is fixed by where a global jump last loaded it
+   * (local_anchor_idx). The global jump table is fixed by the genome, since
+   * neither instruction set regulates it, and cores never fork, so that state
+   * evolves deterministically cycle by cycle as long as the core does not
+   * terminate; a new core is only launched at the start of a step. So if a
+   * core has run since the snapshot, without terminating or acting, and is
+   * back at the snapshot's state, it is on a loop that it has just run through
+   * without acting and will repeat forever.
+   */
+  void UpdateDormancy() {
+    if (!cpu.HasActiveCore()) {
+      loop.valid = false;
+      return;
+    }
+    auto &core = cpu.GetActiveCore();
+    const uint64_t program_counter = core.GetProgramCounter();
+    if (loop.valid && loop.actions == state.actions) {
+      if (loop.program_counter == program_counter &&
+          loop.local_anchor_idx == state.local_anchor_idx &&
+          !std::memcmp(&loop.registers, &core.registers, sizeof(registers_t))) {
+        dormant = true;
+        return;
+      }
+      if (++loop.steps < loop.interval) {
+        return;
+      }
+      loop.interval *= 2;
+    } else {
+      loop.interval = 1;
+    }
+    loop.valid = true;
+    loop.program_counter = program_counter;
+    loop.local_anchor_idx = state.local_anchor_idx;
+    std::memcpy(&loop.registers, &core.registers, sizeof(registers_t));
+    loop.actions = state.actions;
+    loop.steps = 0;
+  }
 
   /**
    * Input: None
@@ -19,13 +116,92 @@ class CPU {
    *
    * Purpose: Initializes the jump table and input buffer in the CPUState.
    * Should be called when a new CPU is created or the program is changed.
+   * The jump tables are copied from the genome's cached CPU instead of being
+   * rebuilt from the program.
    */
   void InitializeState() {
-    cpu.InitializeAnchors(program);
     // Fill the input buffer with random values so they can't cheat and exploit
     // the zeroes that would otherwise be here (e.g. 0^2 is just 0)
-    for (int i = 0; i < 4; i++) {
-      state.last_inputs[i] = sgpl::tlrand.Get().GetUInt();
+    uint32_t inputs[INPUT_WINDOW];
+    for (size_t i = 0; i < INPUT_WINDOW; i++) {
+      inputs[i] = sgpl::tlrand.Get().GetUInt();
+    }
+    InitializeState(inputs);
+  }
+
+  /**
+   * Input: The INPUT_WINDOW values to fill the input buffer with
+   *
+   * Output: None
+   *
+   * Purpose: Initializes the CPU state like InitializeState(), with the given
+   * inputs instead of random ones.
+   */
+  void InitializeState(const uint32_t *inputs) {
+    cpu = genome->pristine_cpu;
+    state.local_anchor_idx = LAUNCH_LOCAL_ANCHORS;
+    ResetDormancy();
+    state.SetInputs(inputs);
+  }
+
+  /**
+   * Input: The stream to read a checkpointed CPU from
+   *
+   * Output: The genome saved at the start of the CPU's checkpoint record
+   *
+   * Purpose: Reads the genome first, so a CPU loaded from a checkpoint can
+   * intern it directly rather than starting from a random one.
+   */
+  static sgpl::Program<Spec> ReadProgram(std::istream &in) {
+    using inst_t = sgpl::Instruction<Spec>;
+    uint64_t length = 0;
+    checkpoint::ReadRaw(in, length);
+    sgpl::Program<Spec> program;
+    program.resize(length);
+    in.read(reinterpret_cast<char *>(program.data()), length * sizeof(inst_t));
+    return program;
+  }
+
+  /**
+   * Input: The stream to read a checkpointed CPU from, just past its genome
+   *
+   * Output: None
+   *
+   * Purpose: Restores the task state and active core saved with Save().
+   */
+  void LoadState(std::istream &in) {
+    cpu = genome->pristine_cpu;
+    ResetDormancy();
+    uint32_t inputs[INPUT_WINDOW];
+    uint64_t input_idx = 0;
+    double points = 0.0;
+    uint32_t tasks_done = 0;
+    checkpoint::ReadRaw(in, inputs);
+    checkpoint::ReadRaw(in, input_idx);
+    checkpoint::ReadRaw(in, points);
+    checkpoint::ReadRaw(in, tasks_done);
+    state.SetInputs(inputs);
+    state.SetInputIdx(input_idx);
+    state.SetPoints(points);
+    state.SetTasksDone(tasks_done);
+
+    uint8_t has_core = 0;
+    checkpoint::ReadRaw(in, has_core);
+    if (has_core) {
+      cpu.TryLaunchCore();
+      auto &core = cpu.GetActiveCore();
+      uint64_t program_counter = 0;
+      uint64_t local_anchor_idx = LAUNCH_LOCAL_ANCHORS;
+      checkpoint::ReadRaw(in, program_counter);
+      checkpoint::ReadRaw(in, local_anchor_idx);
+      // Reload the local jump table where the saved core's last global jump did
+      if (local_anchor_idx != LAUNCH_LOCAL_ANCHORS) {
+        core.JumpToIdx(local_anchor_idx);
+        core.LoadLocalAnchors(genome->program);
+        state.local_anchor_idx = local_anchor_idx;
+      }
+      core.JumpToIdx(program_counter);
+      checkpoint::ReadRaw(in, core.registers);
     }
   }
 
@@ -33,17 +209,52 @@ public:
   OrgState state;
 
   /**
-   * Constructs a new CPU for an ancestor organism with a random genome.
+   * Constructs a new CPU for an ancestor organism with a random genome, whose
+   * state is kept in the world's store at the given cell.
+   */
+  CPU(emp::Ptr<OrgWorldBase> world, GenomeStore<Spec> &genomes, size_t cell)
+      : CPU(world, genomes, cell, sgpl::Program<Spec>(100)) {}
+
+  /**
+   * Constructs a new CPU with a copy of an existing genome.
    */
-  CPU(emp::Ptr<OrgWorld> world) : program(100), state{world} {
+  CPU(emp::Ptr<OrgWorldBase> world, GenomeStore<Spec> &genomes, size_t cell,
+      const sgpl::Program<Spec> &program)
+      : genome(genomes.Intern(program)), state{world, &world->GetStates(), cell} {
+    state.store->Clear(cell);
     InitializeState();
   }
 
   /**
-   * Constructs a new CPU with a copy of an existing genome.
+   * Constructs a new CPU with a copy of an existing genome and the given input
+   * buffer. Nothing is drawn from sgpl::tlrand, so a genome can be run on
+   * test inputs in the middle of a run without changing the run.
+   */
+  CPU(emp::Ptr<OrgWorldBase> world, GenomeStore<Spec> &genomes, size_t cell,
+      const sgpl::Program<Spec> &program, const uint32_t *inputs)
+      : genome(genomes.Intern(program)), state{world, &world->GetStates(), cell} {
+    state.store->Clear(cell);
+    InitializeState(inputs);
+  }
+
+  /**
+   * Constructs a CPU saved with Save(), reading its genome and state from a
+   * checkpoint. Nothing is drawn from sgpl::tlrand.
+   */
+  CPU(emp::Ptr<OrgWorldBase> world, GenomeStore<Spec> &genomes, size_t cell, std::istream &in)
+      : genome(genomes.Intern(ReadProgram(in))), state{world, &world->GetStates(), cell} {
+    state.store->Clear(cell);
+    LoadState(in);
+  }
+
+  /**
+   * Constructs a freshly mutated offspring of the parent for the given cell.
+   * The parent's genome is shared if no mutation lands.
    */
-  CPU(emp::Ptr<OrgWorld> world, const sgpl::Program<Spec> &program)
-      : program(program), state{world} {
+  CPU(const CPU &parent, size_t cell)
+      : genome(parent.genome.GetStore()->Mutate(parent.genome, MUTATION_RATE)),
+        state{parent.state.world, parent.state.store, cell} {
+    state.store->Clear(cell);
     InitializeState();
   }
 
@@ -55,8 +266,7 @@ public:
    * Purpose: Resets the CPU to its initial state.
    */
   void Reset() {
-    cpu.Reset();
-    state = OrgState{state.world};
+    state.store->Clear(state.cell);
     InitializeState();
   }
 
@@ -65,28 +275,106 @@ public:
    *
    * Output: None
    *
-   * Purpose: Steps the CPU forward a certain number of cycles.
+   * Purpose: Steps the CPU forward a certain number of cycles. When the world
+   * skips dormant organisms, a dormant CPU is not run at all, and otherwise the
+   * step is checked for whether it leaves the CPU dormant.
    */
   void RunCPUStep(size_t n_cycles) {
+    const bool skip_dormant = state.world->GetSkipDormant();
+    if (skip_dormant && dormant) {
+      return;
+    }
     if (!cpu.HasActiveCore()) {
       cpu.TryLaunchCore();
+      state.local_anchor_idx = LAUNCH_LOCAL_ANCHORS;
     }
 
-    sgpl::execute_cpu_n_cycles<Spec>(n_cycles, cpu, program, state);
+    sgpl::execute_cpu_n_cycles<Spec>(n_cycles, cpu, genome->program, state);
+    if (skip_dormant) {
+      UpdateDormancy();
+    } else {
+      // Steps that were not watched may have terminated the core
+      loop.valid = false;
+    }
   }
 
+  /**
+   * Input: None
+   *
+   * Output: Whether the CPU can never act again, as far as detected so far
+   *
+   * Purpose: Lets the world tell skipped organisms apart.
+   */
+  bool IsDormant() const { return dormant; }
+
   /**
    * Input: None
    *
    * Output: None
    *
-   * Purpose: Mutates the genome code stored in the CPU.
+   * Purpose: Mutates the genome code stored in the CPU. The shared genome is
+   * never modified; the mutated copy is interned as a genome of its own.
    */
   void Mutate() {
-    program.ApplyPointMutations(0.02);
+    genome = genome.GetStore()->Mutate(genome, MUTATION_RATE);
+    InitializeState();
+  }
+
+  /**
+   * Input: The parent's CPU
+   *
+   * Output: None
+   *
+   * Purpose: Turns this CPU into a freshly mutated offspring of the parent,
+   * reusing this CPU's existing buffers. The parent's genome is copied once into
+   * the store's scratch buffer to be mutated, which becomes the offspring's genome
+   * if it is new, and the parent's is shared instead if no mutation lands; the
+   * CPU state is rebuilt a single time after mutation.
+   */
+  void InheritFrom(const CPU &parent) {
+    genome = genome.GetStore()->Mutate(parent.genome, MUTATION_RATE);
+    state.store->Clear(state.cell);
     InitializeState();
   }
 
+  /**
+   * Input: The stream to write the checkpoint to
+   *
+   * Output: None
+   *
+   * Purpose: Saves the genome, the task state, and the active core's program
+   * counter, where its local jump table was loaded, and registers, which is
+   * all the execution state the instruction set touches. The input stream key
+   * is not saved since it is re-keyed at the start of every update. A dormant
+   * CPU is saved as it stood when it stopped being run; it can never act from
+   * there either, so a resumed run behaves the same and finds it dormant again.
+   */
+  void Save(std::ostream &out) {
+    using inst_t = sgpl::Instruction<Spec>;
+    static_assert(std::is_trivially_copyable<inst_t>::value, "Genomes are checkpointed as raw bytes");
+    const sgpl::Program<Spec> &program = genome->program;
+    const uint64_t length = program.size();
+    checkpoint::WriteRaw(out, length);
+    out.write(reinterpret_cast<const char *>(program.data()), length * sizeof(inst_t));
+
+    uint32_t inputs[INPUT_WINDOW];
+    std::copy_n(state.GetInputs(), INPUT_WINDOW, inputs);
+    checkpoint::WriteRaw(out, inputs);
+    checkpoint::WriteRaw(out, static_cast<uint64_t>(state.GetInputIdx()));
+    checkpoint::WriteRaw(out, state.GetPoints());
+    checkpoint::WriteRaw(out, state.GetTasksDone());
+
+    const uint8_t has_core = cpu.HasActiveCore();
+    checkpoint::WriteRaw(out, has_core);
+    if (has_core) {
+      auto &core = cpu.GetActiveCore();
+      const uint64_t program_counter = core.GetProgramCounter();
+      checkpoint::WriteRaw(out, program_counter);
+      checkpoint::WriteRaw(out, state.local_anchor_idx);
+      checkpoint::WriteRaw(out, core.registers);
+    }
+  }
+
   /**
    * Input: None
    *
@@ -94,9 +382,33 @@ public:
    *
    * Purpose: Get the genome (program) of an Organism from its CPU
    */
-  const sgpl::Program<Spec> &GetProgram() const { return program; }
+  const sgpl::Program<Spec> &GetProgram() const { return genome->program; }
+
+  /**
+   * Input: None
+   *
+   * Output: The hash the genome store keys the CPU's program on
+   *
+   * Purpose: Lets the world compare genomes without hashing them again.
+   */
+  uint64_t GetGenomeHash() const { return genome->hash; }
+
+  /**
+   * Input: None
+   *
+   * Output: The stored genome the CPU runs
+   *
+   * Purpose: Lets the world tell which organisms share a genome by address.
+   */
+  const typename GenomeStore<Spec>::Genome &GetGenome() const { return *genome; }
 
 private:
+  // How many register arguments each simple instruction prints; anything else
+  // is printed as a jump or anchor with its tag
+  inline static const std::map<std::string, size_t> ARITIES{
+      {"Nand", 3}, {"Xor", 3},       {"Add", 3},      {"Subtract", 3},
+      {"Divide", 3}, {"IO", 1},  {"Reproduce", 0}};
+
   /**
    * Input: The instruction to print, and the context needed to print it.
    *
@@ -107,7 +419,7 @@ private:
    */
   void PrintOp(const sgpl::Instruction<Spec> &ins,
                const std::map<std::string, size_t> &arities,
-               sgpl::JumpTable<Spec, Spec::global_matching_t> &table,
+               sgpl::JumpTable<Spec, typename Spec::global_matching_t> &table,
                std::ostream &out = std::cout) const {
     const std::string &name = ins.GetOpName();
     if (arities.count(name)) {
@@ -166,12 +478,84 @@ public:
    * the organism's genome to standard output.
    */
   void PrintGenome(std::ostream &out = std::cout) {
-    std::map<std::string, size_t> arities{{"Nand", 3}, {"Add", 3},
-                                          {"Subtract", 3}, {"Divide", 3},
-                                          {"IO", 1},       {"Reproduce", 0}};
+    // Jump tags are resolved through the running core's jump table
+    if (!cpu.HasActiveCore()) {
+      cpu.TryLaunchCore();
+    }
+    for (const auto &i : genome->program) {
+      PrintOp(i, ARITIES, cpu.GetActiveCore().GetGlobalJumpTable(), out);
+    }
+  }
 
-    for (auto i : program) {
-      PrintOp(i, arities, cpu.GetActiveCore().GetGlobalJumpTable(), out);
+  /**
+   * Input: How many cycles to run, how many cycles the world runs per step, a
+   * seed for the test inputs, and the stream to write to
+   *
+   * Output: None
+   *
+   * Purpose: Runs the CPU one cycle at a time and writes every instruction it
+   * executes with the registers afterwards, and what each IO and successful
+   * Reproduce did. Cores are only launched at the start of steps, as in
+   * RunCPUStep(), so the CPU takes the same path it would in the world. IO
+   * inputs come from a stream keyed on the seed and the step, the same way
+   * the world keys them on its seed and the update.
+   */
+  void Trace(size_t n_cycles, size_t cycles_per_step, uint64_t input_seed, std::ostream &out) {
+    const sgpl::Program<Spec> &program = genome->program;
+    cycles_per_step = std::max<size_t>(cycles_per_step, 1);
+    out << std::setw(8) << "cycle" << std::setw(5) << "pc" << "  " << std::left
+        << std::setw(32) << "instruction" << std::right << "registers after\n";
+    for (size_t cycle = 0; cycle < n_cycles; cycle++) {
+      if (cycle % cycles_per_step == 0) {
+        state.rng.Reset(CounterRandom::MakeKey(input_seed, cycle / cycles_per_step + 1, 0));
+        if (!cpu.HasActiveCore()) {
+          cpu.TryLaunchCore();
+          state.local_anchor_idx = LAUNCH_LOCAL_ANCHORS;
+        }
+      }
+      if (!cpu.HasActiveCore()) {
+        out << std::setw(8) << cycle << "  no core running until the next step\n";
+        cycle += cycles_per_step - 1 - cycle % cycles_per_step;
+        continue;
+      }
+
+      auto &core = cpu.GetActiveCore();
+      const size_t program_counter = core.GetProgramCounter();
+      const sgpl::Instruction<Spec> &inst = program[program_counter];
+      std::ostringstream op;
+      PrintOp(inst, ARITIES, core.GetGlobalJumpTable(), op);
+      std::string op_text = op.str();
+      op_text.pop_back();
+      const bool is_io = inst.GetOpName() == IOInstruction::name();
+      const uint32_t output = is_io ? static_cast<uint32_t>(core.registers[inst.args[0]]) : 0;
+      const uint32_t done = is_io ? state.store->MatchOutput(state.cell, output) : 0;
+      const double points = state.GetPoints();
+      const uint32_t actions = state.actions;
+
+      sgpl::execute_cpu_n_cycles<Spec>(1, cpu, program, state);
+
+      out << std::setw(8) << cycle << std::setw(5) << program_counter << "  " << std::left
+          << std::setw(32) << op_text << std::right;
+      if (cpu.HasActiveCore()) {
+        for (const auto &value : cpu.GetActiveCore().registers) {
+          out << ' ' << value;
+        }
+      } else {
+        out << " (core terminated)";
+      }
+      out << '\n';
+      if (state.actions != actions && is_io) {
+        out << std::setw(15) << "" << "output " << output << " performs";
+        for (size_t task = 0; task < NUM_TASKS; task++) {
+          if ((done >> task) & 1) {
+            out << ' ' << TASK_NAMES[task];
+          }
+        }
+        out << (done ? "" : " no task") << ", points " << points << " -> " << state.GetPoints()
+            << '\n';
+      } else if (state.actions != actions) {
+        out << std::setw(15) << "" << "reproduces with " << points << " points\n";
+      }
     }
   }
 };
@@ -0,0 +1,418 @@
+#ifndef CENSUS_FILE_H
+#define CENSUS_FILE_H
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "Task.h"
+
+/**
+ * One row of census output: the update number and how many organisms have
+ * performed each task, indexed by TaskId.
+ */
+struct CensusRow {
+  uint32_t update;
+  std::array<int32_t, NUM_TASKS> counts;
+};
+
+/** Number of columns in a census row: the update followed by one per task. */
+constexpr size_t CENSUS_COLUMNS = NUM_TASKS + 1;
+
+/**
+ * Input: None
+ *
+ * Output: The column names of a census row, matching the text data file header
+ *
+ * Purpose: Shared by the binary writer and the text converter.
+ */
+inline std::vector<std::string> GetCensusColumnNames() {
+  std::vector<std::string> names{"update"};
+  for (size_t task = 0; task < NUM_TASKS; task++) {
+    names.push_back(std::string(TASK_NAMES[task]) + " count");
+  }
+  return names;
+}
+
+/**
+ * Input: A line of a text census file
+ *
+ * Output: Whether the line is a complete row, with its update number stored in
+ * update if so
+ *
+ * Purpose: Lets a resumed run keep the rows an earlier run wrote while
+ * dropping blank lines and a last row cut short by an interruption.
+ */
+inline bool ParseCensusLine(const std::string &line, uint64_t &update) {
+  const char *pos = line.data();
+  const char *const end = line.data() + line.size();
+  for (size_t column = 0; column < CENSUS_COLUMNS; column++) {
+    if (column && (pos == end || *pos++ != ',')) {
+      return false;
+    }
+    int64_t value = 0;
+    const std::from_chars_result result = std::from_chars(pos, end, value);
+    if (result.ec != std::errc() || (!column && value < 0)) {
+      return false;
+    }
+    if (!column) {
+      update = static_cast<uint64_t>(value);
+    }
+    pos = result.ptr;
+  }
+  return pos == end;
+}
+
+/**
+ * The interface for a destination of census rows.
+ */
+class CensusOutput {
+public:
+  virtual ~CensusOutput() = default;
+
+  /** Appends one row. */
+  virtual void Write(const CensusRow &row) = 0;
+
+  /** Makes every row written so far readable from the file. */
+  virtual void Flush() = 0;
+};
+
+/**
+ * Writes census rows in the same comma-separated format, header included, as
+ * the emp::DataFile set up by OrgWorld::SetupDataFile.
+ */
+class TextCensusFile : public CensusOutput {
+  std::ofstream file;
+  std::string line;
+
+public:
+  /**
+   * Creates the file and writes the header line. If resume_update is nonzero
+   * and the file already exists, its complete rows from before that update are
+   * kept and writing continues after them instead; blank lines and rows missing
+   * columns are dropped.
+   */
+  explicit TextCensusFile(const std::string &filename, size_t resume_update = 0) {
+    std::vector<std::string> kept_lines;
+    if (resume_update) {
+      std::ifstream old_file(filename);
+      std::string old_line;
+      // The first line is the header
+      std::getline(old_file, old_line);
+      while (std::getline(old_file, old_line)) {
+        uint64_t row_update = 0;
+        if (ParseCensusLine(old_line, row_update) && row_update < resume_update) {
+          kept_lines.push_back(old_line);
+        }
+      }
+    }
+    file.open(filename, std::ios::trunc);
+    if (!file) {
+      std::cerr << "Could not open data file " << filename << std::endl;
+      return;
+    }
+    bool first = true;
+    for (const std::string &name : GetCensusColumnNames()) {
+      if (!first) {
+        file << ',';
+      }
+      first = false;
+      file << name;
+    }
+    file << '\n';
+    for (const std::string &kept_line : kept_lines) {
+      file << kept_line << '\n';
+    }
+  }
+
+  ~TextCensusFile() override { Flush(); }
+
+  void Write(const CensusRow &row) override {
+    line = std::to_string(row.update);
+    for (int32_t count : row.counts) {
+      line += ',';
+      line += std::to_string(count);
+    }
+    line += '\n';
+    file << line;
+  }
+
+  void Flush() override { file.flush(); }
+};
+
+/**
+ * The fixed-width binary columnar census format, which can be read in place
+ * (e.g. with mmap or numpy.memmap) without parsing.
+ *
+ * Layout, all integers little-endian:
+ *   header:
+ *     char[8]   magic "ORGCENS1"
+ *     uint32    version (1)
+ *     uint32    number of columns
+ *     uint32    rows per block
+ *     uint32    reserved (0)
+ *     uint64    number of rows written
+ *     char[16]  zero-padded name of each column
+ *   blocks of `rows per block` rows, each stored column-major: column c of
+ *   block b starts at header_size + (b * columns + c) * rows_per_block * 4.
+ *   Every column is 32 bits wide. The last block is padded to full size;
+ *   readers stop at the row count in the header.
+ */
+struct BinaryCensusLayout {
+  static constexpr char MAGIC[8] = {'O', 'R', 'G', 'C', 'E', 'N', 'S', '1'};
+  static constexpr uint32_t VERSION = 1;
+  static constexpr uint32_t BLOCK_ROWS = 4096;
+  static constexpr size_t NAME_WIDTH = 16;
+  static constexpr size_t ROW_COUNT_OFFSET = 24;
+
+  /**
+   * Input: The number of columns
+   *
+   * Output: The size of the header in bytes
+   *
+   * Purpose: Locates the first block.
+   */
+  static size_t HeaderSize(size_t num_columns) { return 32 + NAME_WIDTH * num_columns; }
+};
+
+/**
+ * Reads a binary census file written by BinaryCensusFile.
+ */
+class BinaryCensusReader {
+  std::vector<char> data;
+  std::vector<std::string> column_names;
+  uint64_t num_rows = 0;
+  uint32_t block_rows = 0;
+  bool valid = false;
+
+  uint64_t GetLE(size_t offset, size_t num_bytes) const {
+    uint64_t value = 0;
+    for (size_t i = 0; i < num_bytes; i++) {
+      value |= static_cast<uint64_t>(static_cast<unsigned char>(data[offset + i])) << (8 * i);
+    }
+    return value;
+  }
+
+public:
+  /**
+   * Loads and validates the file. Check IsValid() before reading values.
+   */
+  explicit BinaryCensusReader(const std::string &filename) {
+    std::ifstream file(filename, std::ios::binary);
+    data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    if (data.size() < 32 ||
+        std::memcmp(data.data(), BinaryCensusLayout::MAGIC, sizeof(BinaryCensusLayout::MAGIC)) ||
+        GetLE(8, 4) != BinaryCensusLayout::VERSION) {
+      return;
+    }
+    const size_t num_columns = GetLE(12, 4);
+    block_rows = GetLE(16, 4);
+    num_rows = GetLE(BinaryCensusLayout::ROW_COUNT_OFFSET, 8);
+    if (block_rows == 0 || data.size() < BinaryCensusLayout::HeaderSize(num_columns)) {
+      return;
+    }
+    for (size_t col = 0; col < num_columns; col++) {
+      const char *name = data.data() + 32 + col * BinaryCensusLayout::NAME_WIDTH;
+      column_names.emplace_back(name, std::find(name, name + BinaryCensusLayout::NAME_WIDTH, '\0'));
+    }
+    const size_t num_blocks = (num_rows + block_rows - 1) / block_rows;
+    valid = data.size() >= BinaryCensusLayout::HeaderSize(num_columns) +
+                               num_blocks * block_rows * num_columns * 4;
+  }
+
+  bool IsValid() const { return valid; }
+  uint64_t GetNumRows() const { return num_rows; }
+  const std::vector<std::string> &GetColumnNames() const { return column_names; }
+
+  /**
+   * Input: A row and column index
+   *
+   * Output: The stored value
+   *
+   * Purpose: Random access into the columnar layout.
+   */
+  uint32_t Get(uint64_t row, size_t col) const {
+    const uint64_t block = row / block_rows;
+    const uint64_t offset = BinaryCensusLayout::HeaderSize(column_names.size()) +
+                            ((block * column_names.size() + col) * block_rows +
+                             row % block_rows) * 4;
+    return static_cast<uint32_t>(GetLE(offset, 4));
+  }
+
+  /**
+   * Input: The stream to write to
+   *
+   * Output: None
+   *
+   * Purpose: Writes the data in the same comma-separated format as the text
+   * data file, header included. Task counts are signed, the update is not.
+   */
+  void PrintText(std::ostream &out) const {
+    for (size_t col = 0; col < column_names.size(); col++) {
+      if (col) {
+        out << ',';
+      }
+      out << column_names[col];
+    }
+    out << '\n';
+    for (uint64_t row = 0; row < num_rows; row++) {
+      out << Get(row, 0);
+      for (size_t col = 1; col < column_names.size(); col++) {
+        out << ',' << static_cast<int32_t>(Get(row, col));
+      }
+      out << '\n';
+    }
+  }
+};
+
+/**
+ * Writes census rows in the binary columnar format described by
+ * BinaryCensusLayout.
+ */
+class BinaryCensusFile : public CensusOutput, private BinaryCensusLayout {
+private:
+  std::ofstream file;
+  std::vector<uint32_t> block; // current block, column-major
+  uint64_t num_rows = 0;
+  uint64_t block_index = 0;
+  size_t block_fill = 0;
+
+  static void PutLE(std::ostream &out, uint64_t value, size_t num_bytes) {
+    for (size_t i = 0; i < num_bytes; i++) {
+      out.put(static_cast<char>((value >> (8 * i)) & 0xFF));
+    }
+  }
+
+  /**
+   * Input: None
+   *
+   * Output: None
+   *
+   * Purpose: Writes the current block (padded) at its slot in the file and
+   * updates the row count in the header.
+   */
+  void WriteBlock() {
+    const size_t block_bytes = BLOCK_ROWS * CENSUS_COLUMNS * 4;
+    file.seekp(HeaderSize(CENSUS_COLUMNS) + block_index * block_bytes);
+    for (uint32_t value : block) {
+      PutLE(file, value, 4);
+    }
+    file.seekp(ROW_COUNT_OFFSET);
+    PutLE(file, num_rows, 8);
+  }
+
+  /**
+   * Input: The existing file and the update to resume from
+   *
+   * Output: Whether the file could be resumed
+   *
+   * Purpose: Drops rows from resume_update onward and reloads the last
+   * partial block so new rows are appended after the kept ones.
+   */
+  bool Resume(const std::string &filename, size_t resume_update) {
+    BinaryCensusReader reader(filename);
+    if (!reader.IsValid() || reader.GetColumnNames().size() != CENSUS_COLUMNS) {
+      return false;
+    }
+    uint64_t kept_rows = 0;
+    while (kept_rows < reader.GetNumRows() && reader.Get(kept_rows, 0) < resume_update) {
+      kept_rows++;
+    }
+    file.open(filename, std::ios::binary | std::ios::in | std::ios::out);
+    if (!file) {
+      return false;
+    }
+    num_rows = kept_rows;
+    block_index = kept_rows / BLOCK_ROWS;
+    block_fill = kept_rows % BLOCK_ROWS;
+    for (uint64_t row = block_index * BLOCK_ROWS; row < kept_rows; row++) {
+      for (size_t col = 0; col < CENSUS_COLUMNS; col++) {
+        block[col * BLOCK_ROWS + row % BLOCK_ROWS] = reader.Get(row, col);
+      }
+    }
+    WriteBlock();
+    return true;
+  }
+
+public:
+  /**
+   * Creates the file and writes its header. If resume_update is nonzero and
+   * the file already holds valid census data, its rows from before that update
+   * are kept and writing continues after them instead.
+   */
+  explicit BinaryCensusFile(const std::string &filename, size_t resume_update = 0)
+      : block(BLOCK_ROWS * CENSUS_COLUMNS, 0) {
+    if (resume_update && Resume(filename, resume_update)) {
+      return;
+    }
+    file.open(filename, std::ios::binary | std::ios::trunc);
+    if (!file) {
+      std::cerr << "Could not open binary data file " << filename << std::endl;
+      return;
+    }
+    file.write(MAGIC, sizeof(MAGIC));
+    PutLE(file, VERSION, 4);
+    PutLE(file, CENSUS_COLUMNS, 4);
+    PutLE(file, BLOCK_ROWS, 4);
+    PutLE(file, 0, 4);
+    PutLE(file, 0, 8);
+    for (const std::string &name : GetCensusColumnNames()) {
+      char padded[NAME_WIDTH] = {};
+      std::strncpy(padded, name.c_str(), NAME_WIDTH - 1);
+      file.write(padded, NAME_WIDTH);
+    }
+  }
+
+  ~BinaryCensusFile() override { Flush(); }
+
+  BinaryCensusFile(const BinaryCensusFile &) = delete;
+  BinaryCensusFile &operator=(const BinaryCensusFile &) = delete;
+
+  /**
+   * Input: A census row
+   *
+   * Output: None
+   *
+   * Purpose: Appends the row, writing the block out once it is full.
+   */
+  void Write(const CensusRow &row) override {
+    block[block_fill] = row.update;
+    for (size_t task = 0; task < NUM_TASKS; task++) {
+      block[(task + 1) * BLOCK_ROWS + block_fill] = static_cast<uint32_t>(row.counts[task]);
+    }
+    block_fill++;
+    num_rows++;
+    if (block_fill == BLOCK_ROWS) {
+      WriteBlock();
+      std::fill(block.begin(), block.end(), 0);
+      block_fill = 0;
+      block_index++;
+    }
+  }
+
+  /**
+   * Input: None
+   *
+   * Output: None
+   *
+   * Purpose: Makes every row written so far readable from the file.
+   */
+  void Flush() override {
+    if (!file) {
+      return;
+    }
+    if (block_fill) {
+      WriteBlock();
+    }
+    file.flush();
+  }
+};
+
+#endif
@@ -0,0 +1,46 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <type_traits>
+
+/**
+ * Helpers for the binary checkpoint format written by
+ * OrgWorld::SaveCheckpoint. Values are stored as raw bytes in the host's
+ * layout, so a checkpoint is only meant to be resumed by the same build on
+ * the same kind of machine.
+ */
+namespace checkpoint {
+
+constexpr char MAGIC[8] = {'O', 'R', 'G', 'C', 'H', 'K', 'P', '1'};
+constexpr uint32_t VERSION = 4;
+
+/**
+ * Input: The stream to write to and a trivially copyable value
+ *
+ * Output: None
+ *
+ * Purpose: Writes the value's bytes.
+ */
+template <typename T> void WriteRaw(std::ostream &out, const T &value) {
+  static_assert(std::is_trivially_copyable<T>::value, "Only raw-copyable values can be checkpointed");
+  out.write(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+/**
+ * Input: The stream to read from and the value to overwrite
+ *
+ * Output: None
+ *
+ * Purpose: Reads back a value written by WriteRaw.
+ */
+template <typename T> void ReadRaw(std::istream &in, T &value) {
+  static_assert(std::is_trivially_copyable<T>::value, "Only raw-copyable values can be checkpointed");
+  in.read(reinterpret_cast<char *>(&value), sizeof(T));
+}
+
+} // namespace checkpoint
+
+#endif
@@ -7,7 +7,34 @@ EMP_BUILD_CONFIG(MyConfigType,
   VALUE(SEED, int, 10, "What value should the random seed be?"),
   VALUE(UPDATES, int, 100, "How many updates should the program run for?"),
   VALUE(FILE_NAME, std::string, "DataFile.dat", "Root output file name"),
-  VALUE(REWARD, bool, true, "Should all tasks receive rewards?")
+  VALUE(BINARY_DATA, bool, false, "Should the data file be written in binary columnar format?"),
+  VALUE(ASYNC_DATA, bool, false, "Should the data file be written from a background thread?"),
+  VALUE(CHECKPOINT_INTERVAL, int, 0, "How many updates between checkpoints? (0 to disable)"),
+  VALUE(CHECKPOINT_FILE, std::string, "checkpoint.bin", "Checkpoint file to save to and resume from"),
+  VALUE(PHYLOGENY_INTERVAL, int, 0, "How many updates between phylogeny snapshots? (0 to disable lineage tracking)"),
+  VALUE(GENOTYPE_INTERVAL, int, 0, "How many updates between reports of the most abundant genotypes? (0 to disable)"),
+  VALUE(GENOTYPE_TOP, int, 10, "How many of the most abundant genotypes should each report list?"),
+  VALUE(GENOTYPE_TRACE, int, 0, "How many CPU cycles should each reported genotype be traced for on test inputs? (0 for no traces)"),
+  VALUE(STATS_INTERVAL, int, 0, "How many updates between lines of the update timing and counter log? (0 to disable)"),
+  VALUE(REPLAY_LOG, bool, false, "Should hashes of the population be logged after every update, to compare runs with?"),
+  VALUE(BATCH_FILE, std::string, "", "File of 'SEED REWARD XOR UPDATES [FILE_NAME]' lines to run together (empty for a single run)"),
+  VALUE(BATCH_THREADS, int, 0, "How many batch runs should execute at once? (0 for one per core)"),
+  VALUE(REWARD, bool, true, "Should all tasks receive rewards?"),
+  VALUE(XOR_INSTRUCTION, bool, true, "Should organisms have the XOR instruction as well as NAND?"),
+  VALUE(RESOURCES, bool, false, "Should task rewards depend on per-task resources that organisms deplete?"),
+  VALUE(RESOURCE_INFLOW, double, 1.0, "How much of each task's resource flows into every cell per update?"),
+  VALUE(RESOURCE_OUTFLOW, double, 0.01, "What fraction of each cell's resources drains away per update? (above 0)"),
+  VALUE(RESOURCE_DIFFUSION, double, 0.1, "What fraction of a cell's resources spreads to each of its 4 neighbors per update? (at most 0.25)"),
+  VALUE(RESOURCE_UPTAKE, double, 0.01, "What fraction of its cell's resource does performing a task use up?"),
+  VALUE(WIDTH, int, 60, "How many cells wide should the world grid be? (above 0)"),
+  VALUE(HEIGHT, int, 60, "How many cells tall should the world grid be? (above 0)"),
+  VALUE(NEIGHBORHOOD, int, 0, "Which cells can offspring be placed in? (0 the 8 around the parent, 1 the 4 beside it)"),
+  VALUE(INITIAL_POP, int, 3600, "How many organisms should the world start with?"),
+  VALUE(CYCLES_PER_ORG, int, 10, "How many CPU cycles should organisms run per update, on average?"),
+  VALUE(MERIT, int, 0, "What should CPU cycles be shared out by? (0 equally, 1 completed tasks, 2 points; with 1 or 2 each organism gets its expected share, rounded at random)"),
+  VALUE(SKIP_DORMANT, bool, true, "Should organisms that provably can never do IO or reproduce again stop being run?"),
+  VALUE(UPDATES_PER_FRAME, int, 1, "How many updates should the web view run between redraws?"),
+  VALUE(THREADS, int, 1, "How many threads should process organisms each update?")
 )
 
 #endif // CONFIG_SETUP_H
\ No newline at end of file
@@ -0,0 +1,90 @@
+#ifndef COUNTER_RANDOM_H
+#define COUNTER_RANDOM_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+/**
+ * A counter-based random number stream. Every value is a pure function of the
+ * stream key and how many values have been drawn, so a stream keyed on
+ * (seed, update, cell) produces the same sequence no matter which thread runs
+ * the cell or in what order cells are processed.
+ */
+struct CounterRandom {
+  uint64_t key = 0;
+  uint64_t counter = 0;
+
+  /**
+   * Input: A 64-bit value
+   *
+   * Output: A well-mixed 64-bit value
+   *
+   * Purpose: The SplitMix64 finalizer, used both to derive keys and to turn
+   * (key, counter) pairs into random values.
+   */
+  static uint64_t Mix(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+  }
+
+  /**
+   * Input: A buffer and its size in bytes
+   *
+   * Output: A 64-bit hash of the bytes
+   *
+   * Purpose: Hashes raw memory, such as genomes and generator states, by
+   * mixing in eight bytes at a time.
+   */
+  static uint64_t HashBytes(const void *data, size_t num_bytes) {
+    const unsigned char *bytes = static_cast<const unsigned char *>(data);
+    uint64_t hash = num_bytes;
+    size_t i = 0;
+    for (; i + sizeof(uint64_t) <= num_bytes; i += sizeof(uint64_t)) {
+      uint64_t word;
+      std::memcpy(&word, bytes + i, sizeof(word));
+      hash = Mix(hash ^ word);
+    }
+    uint64_t tail = 0;
+    std::memcpy(&tail, bytes + i, num_bytes - i);
+    return Mix(hash ^ tail);
+  }
+
+  /**
+   * Input: The run's seed, the current update, and the cell being processed
+   *
+   * Output: The key of the stream for that cell during that update
+   *
+   * Purpose: Derives independent per-cell, per-update stream keys.
+   */
+  static uint64_t MakeKey(uint64_t seed, uint64_t update, uint64_t cell) {
+    return Mix(Mix(Mix(seed) ^ update) ^ cell);
+  }
+
+  /**
+   * Input: A stream key
+   *
+   * Output: None
+   *
+   * Purpose: Restarts the stream at the beginning of the given key.
+   */
+  void Reset(uint64_t new_key) {
+    key = new_key;
+    counter = 0;
+  }
+
+  /**
+   * Input: None
+   *
+   * Output: The next 32-bit value in the stream
+   *
+   * Purpose: Draws a random value and advances the counter.
+   */
+  uint32_t GetUInt() {
+    return static_cast<uint32_t>(Mix(key ^ (++counter * 0xD6E8FEB86659FD93ull)) >> 32);
+  }
+};
+
+#endif
@@ -0,0 +1,231 @@
+#ifndef GENOME_STORE_H
+#define GENOME_STORE_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+
+#include "CounterRandom.h"
+#include "Instructions.h"
+#include "emp/base/Ptr.hpp"
+#include "sgpl/hardware/Cpu.hpp"
+#include "sgpl/program/Program.hpp"
+
+/**
+ * Deduplicates the genomes of a world. Every distinct program is stored once,
+ * keyed on a hash of its contents, together with a CPU whose jump tables have
+ * already been built from it; organisms hold counted handles to these shared
+ * genomes. A genome is freed when the last organism holding it is replaced.
+ *
+ * Offspring that come through mutation unchanged, and independently arising
+ * duplicates, share one program buffer and skip rebuilding the jump tables.
+ * The store is not thread-safe: genomes are only created and released while
+ * births are processed, which happens on one thread.
+ */
+template <typename Spec>
+class GenomeStore {
+public:
+  using program_t = sgpl::Program<Spec>;
+  using cpu_t = sgpl::Cpu<Spec>;
+
+  /**
+   * One distinct genome. Never modified once stored.
+   */
+  struct Genome {
+    program_t program;
+    // A CPU with no cores whose jump tables are initialized from program
+    cpu_t pristine_cpu;
+    uint64_t hash;
+    // Whether the program has any IO or Reproduce instruction; see IsActionOp()
+    bool can_act;
+    size_t refs = 0;
+  };
+
+  /**
+   * A counted reference to a stored genome. Copying a handle shares the genome;
+   * the genome is removed from its store when the last handle goes away.
+   */
+  class Handle {
+    emp::Ptr<GenomeStore> store;
+    emp::Ptr<Genome> genome;
+
+    void Release() {
+      if (genome && --genome->refs == 0) {
+        store->Erase(genome);
+      }
+      genome = nullptr;
+    }
+
+  public:
+    Handle() = default;
+    Handle(emp::Ptr<GenomeStore> _store, emp::Ptr<Genome> _genome) : store(_store), genome(_genome) {
+      genome->refs++;
+    }
+    Handle(const Handle &other) : store(other.store), genome(other.genome) {
+      if (genome) { genome->refs++; }
+    }
+    Handle &operator=(const Handle &other) {
+      if (other.genome) { other.genome->refs++; }
+      Release();
+      store = other.store;
+      genome = other.genome;
+      return *this;
+    }
+    ~Handle() { Release(); }
+
+    const Genome &operator*() const { return *genome; }
+    const Genome *operator->() const { return genome.Raw(); }
+    emp::Ptr<GenomeStore> GetStore() const { return store; }
+  };
+
+private:
+  std::unordered_multimap<uint64_t, emp::Ptr<Genome>> genomes;
+  // The offspring program being mutated. Clean births reuse its buffer; a mutated
+  // birth that makes a new genome hands the buffer over to it
+  program_t scratch;
+  size_t total_instructions = 0;
+
+  static_assert(std::is_trivially_copyable<sgpl::Instruction<Spec>>::value,
+                "Genomes are hashed and compared as raw bytes");
+
+  /**
+   * Input: A program
+   *
+   * Output: A hash of its raw instruction bytes
+   *
+   * Purpose: Keys the genome table.
+   */
+  static uint64_t Hash(const program_t &program) {
+    return CounterRandom::HashBytes(program.data(),
+                                    program.size() * sizeof(sgpl::Instruction<Spec>));
+  }
+
+  static bool Equal(const program_t &a, const program_t &b) {
+    return a.size() == b.size() &&
+           !std::memcmp(a.data(), b.data(), a.size() * sizeof(sgpl::Instruction<Spec>));
+  }
+
+  /**
+   * Input: A program and its hash
+   *
+   * Output: The stored genome with the same contents, or null if there is none
+   *
+   * Purpose: Looks a program up before interning it.
+   */
+  emp::Ptr<Genome> Find(const program_t &program, uint64_t hash) const {
+    auto range = genomes.equal_range(hash);
+    for (auto it = range.first; it != range.second; ++it) {
+      if (Equal(it->second->program, program)) {
+        return it->second;
+      }
+    }
+    return nullptr;
+  }
+
+  /**
+   * Input: A program that is not stored yet, and its hash
+   *
+   * Output: A handle to the new genome
+   *
+   * Purpose: Stores the program, taking its buffer, and builds its jump tables.
+   */
+  Handle Store(program_t &&program, uint64_t hash) {
+    emp::Ptr<Genome> genome = emp::NewPtr<Genome>();
+    genome->program = std::move(program);
+    genome->pristine_cpu.InitializeAnchors(genome->program);
+    genome->hash = hash;
+    genome->can_act = std::any_of(genome->program.begin(), genome->program.end(),
+                                  [](const auto &inst) { return IsActionOp<Spec>(inst.op_code); });
+    genomes.emplace(hash, genome);
+    total_instructions += genome->program.size();
+    return Handle(this, genome);
+  }
+
+  void Erase(emp::Ptr<Genome> genome) {
+    auto range = genomes.equal_range(genome->hash);
+    for (auto it = range.first; it != range.second; ++it) {
+      if (it->second == genome) {
+        genomes.erase(it);
+        break;
+      }
+    }
+    total_instructions -= genome->program.size();
+    genome.Delete();
+  }
+
+public:
+  GenomeStore() = default;
+  GenomeStore(const GenomeStore &) = delete;
+  GenomeStore &operator=(const GenomeStore &) = delete;
+
+  /**
+   * Every organism must have been destroyed first.
+   */
+  ~GenomeStore() {
+    for (auto &entry : genomes) {
+      entry.second.Delete();
+    }
+  }
+
+  /**
+   * Input: A program
+   *
+   * Output: A handle to the stored genome with the same contents
+   *
+   * Purpose: Looks the program up, and stores a copy of it, with its jump
+   * tables built, only if no identical genome is stored yet.
+   */
+  Handle Intern(const program_t &program) {
+    const uint64_t hash = Hash(program);
+    if (emp::Ptr<Genome> genome = Find(program, hash)) {
+      return Handle(this, genome);
+    }
+    return Store(program_t(program), hash);
+  }
+
+  /**
+   * Input: A program the caller no longer needs
+   *
+   * Output: A handle to the stored genome with the same contents
+   *
+   * Purpose: As above, but a new genome takes over the program's buffer
+   * instead of copying it. The program is left untouched if it was found.
+   */
+  Handle Intern(program_t &&program) {
+    const uint64_t hash = Hash(program);
+    if (emp::Ptr<Genome> genome = Find(program, hash)) {
+      return Handle(this, genome);
+    }
+    return Store(std::move(program), hash);
+  }
+
+  /**
+   * Input: The parent's genome and the per-instruction mutation rate
+   *
+   * Output: A handle to the offspring's genome
+   *
+   * Purpose: Copy-on-mutate. The parent's program is copied into the scratch
+   * buffer and mutated there, since sgpl mutates a whole program in place; if
+   * no mutation landed the parent's genome is shared as is, otherwise the
+   * result is interned by moving it, so a new genome is copied only once.
+   */
+  Handle Mutate(const Handle &parent, double mutation_rate) {
+    scratch = parent->program;
+    scratch.ApplyPointMutations(mutation_rate);
+    if (Equal(scratch, parent->program)) {
+      return parent;
+    }
+    return Intern(std::move(scratch));
+  }
+
+  /** The number of distinct genomes stored. */
+  size_t GetNumGenomes() const { return genomes.size(); }
+
+  /** The number of instructions across all distinct genomes. */
+  size_t GetNumInstructions() const { return total_instructions; }
+};
+
+#endif
@@ -1,18 +1,21 @@
 #ifndef INSTRUCTIONS_H
 #define INSTRUCTIONS_H
 
+#include <string>
+#include <vector>
+
 #include "OrgState.h"
+#include "OrgWorldBase.h"
 #include "sgpl/library/OpLibraryCoupler.hpp"
 #include "sgpl/library/prefab/ArithmeticOpLibrary.hpp"
 #include "sgpl/library/prefab/NopOpLibrary.hpp"
 #include "sgpl/operations/flow_global/Anchor.hpp"
+#include "sgpl/operations/flow_global/JumpIfNot.hpp"
 #include "sgpl/program/Instruction.hpp"
 #include "sgpl/program/Program.hpp"
 #include "sgpl/spec/Spec.hpp"
 //#include <_types/_uint32_t.h>
 
-constexpr bool xor_bool = true; // Set to true or false as needed
-
 /**
  * A custom instruction that outputs the value of a register as the (possible)
  * solution to a task, and then gets a new input value and stores it in the same
@@ -27,9 +30,10 @@ struct IOInstruction {
     bool reward = state.world->GetReward();
     state.world->CheckOutput(reward, output, state);
 
-    uint32_t input = sgpl::tlrand.Get().GetUInt();
+    uint32_t input = state.rng.GetUInt();
     core.registers[inst.args[0]] = input;
     state.add_input(input);
+    state.actions++;
   }
 
   static std::string name() { return "IO"; }
@@ -164,9 +168,10 @@ struct ReproduceInstruction {
   static void run(sgpl::Core<Spec> &core, const sgpl::Instruction<Spec> &inst,
                   const sgpl::Program<Spec> &,
                   typename Spec::peripheral_t &state) noexcept {
-    if (state.points > 189) {
-      state.world->ReproduceOrg(state.current_location);
-      state.points = 0;
+    if (state.GetPoints() > 189) {
+      state.world->ReproduceOrg(state.cell);
+      state.SetPoints(0);
+      state.actions++;
     }
     
   }
@@ -175,19 +180,72 @@ struct ReproduceInstruction {
   static size_t prevalence() { return 1; }
 };
 
+/**
+ * SignalGP-Lite's global JumpIfNot, which also records in the state where the
+ * core's local jump table was loaded. The local anchors are (re)loaded at the
+ * landing point whether or not an anchor matched, so the table is always the
+ * one for the recorded index. The table is otherwise hidden in the core, and
+ * the dormancy check and checkpoints both need to know it.
+ */
+struct GlobalJumpIfNotInstruction {
+  template <typename Spec>
+  static void run(sgpl::Core<Spec> &core, const sgpl::Instruction<Spec> &inst,
+                  const sgpl::Program<Spec> &program,
+                  typename Spec::peripheral_t &state) noexcept {
+    const bool jumps = !core.registers[inst.args[0]];
+    sgpl::global::JumpIfNot::run<Spec>(core, inst, program, state);
+    if (jumps) {
+      core.LoadLocalAnchors(program);
+      state.local_anchor_idx = core.GetProgramCounter();
+    }
+  }
 
-using Library = std::conditional_t<
-    xor_bool,
+  static std::string name() { return sgpl::global::JumpIfNot::name(); }
+  static size_t prevalence() { return sgpl::global::JumpIfNot::prevalence(); }
+};
+
+/**
+ * The two instruction sets the experiments compare. Both are compiled into every
+ * binary; the XOR_INSTRUCTION setting picks one when a world is created, and each
+ * world type is instantiated for a single set so no instruction ever checks which
+ * set is in use.
+ */
+// NAND is the only logic instruction
+using NandLibrary =
     sgpl::OpLibraryCoupler<sgpl::NopOpLibrary, sgpl::BitwiseShift, sgpl::Increment, sgpl::Decrement,
-                           sgpl::Add, sgpl::Subtract, sgpl::global::JumpIfNot, sgpl::local::JumpIfNot, sgpl::global::Anchor, IOInstruction, NandInstruction,
+                           sgpl::Add, sgpl::Subtract, GlobalJumpIfNotInstruction, sgpl::local::JumpIfNot, sgpl::global::Anchor, IOInstruction, NandInstruction,
                            //NotInstruction, AndInstruction, OrnInstruction, OrInstruction, AndnInstruction, NorInstruction,
-                           XorInstruction, ReproduceInstruction>,
+                           ReproduceInstruction>;
+// NAND and XOR are both built in
+using NandXorLibrary =
     sgpl::OpLibraryCoupler<sgpl::NopOpLibrary, sgpl::BitwiseShift, sgpl::Increment, sgpl::Decrement,
-                           sgpl::Add, sgpl::Subtract, sgpl::global::JumpIfNot, sgpl::local::JumpIfNot, sgpl::global::Anchor, IOInstruction, NandInstruction,
+                           sgpl::Add, sgpl::Subtract, GlobalJumpIfNotInstruction, sgpl::local::JumpIfNot, sgpl::global::Anchor, IOInstruction, NandInstruction,
                            //NotInstruction, AndInstruction, OrnInstruction, OrInstruction, AndnInstruction, NorInstruction,
-                           ReproduceInstruction>
->;
+                           XorInstruction, ReproduceInstruction>;
 
-using Spec = sgpl::Spec<Library, OrgState>;
+using NandSpec = sgpl::Spec<NandLibrary, OrgState>;
+using NandXorSpec = sgpl::Spec<NandXorLibrary, OrgState>;
+
+/**
+ * Input: An op code of the instruction set described by Spec
+ *
+ * Output: Whether the instruction can act on anything outside its CPU's core
+ *
+ * Purpose: IO and Reproduce are the only instructions that reach the organism's
+ * state or the world; every other one only changes registers and the program
+ * counter. A genome without either can never affect the simulation.
+ */
+template <typename Spec>
+bool IsActionOp(size_t op_code) {
+  static const std::vector<bool> actions = [] {
+    std::vector<bool> table(Spec::library_t::GetSize());
+    for (size_t op = 0; op < table.size(); op++) {
+      const std::string name = Spec::library_t::GetOpName(op);
+      table[op] = name == IOInstruction::name() || name == ReproduceInstruction::name();
+    }
+    return table;
+  }();
+  return actions[op_code];
+}
 
-#endif  
\ No newline at end of file
+#endif
@@ -5,34 +5,56 @@
 #include "OrgState.h"
 #include "emp/Evolve/World_structure.hpp"
 
+// Organisms are created by, and get their genome store from, the world type
+// for their instruction set, which is defined in World.h
+template <typename Spec> class OrgWorld;
+
+template <typename Spec>
 class Organism {
-  CPU cpu;
+  CPU<Spec> cpu;
 
 public:
-  Organism(emp::Ptr<OrgWorld> world, double points = 0.0) : cpu(world) {
+  /**
+   * Creates an ancestor with a random genome for the given cell.
+   */
+  Organism(emp::Ptr<OrgWorld<Spec>> world, size_t cell, double points = 0.0)
+      : cpu(world, world->GetGenomes(), cell) {
     SetPoints(points);
   }
 
+  /**
+   * Restores an organism saved with Save() from a checkpoint into the given cell.
+   *
+   * @param in the checkpoint stream
+   */
+  Organism(emp::Ptr<OrgWorld<Spec>> world, size_t cell, std::istream &in)
+      : cpu(world, world->GetGenomes(), cell, in) {}
+
+  /**
+   * Creates a mutated offspring of the parent for the given cell.
+   */
+  Organism(const Organism &parent, size_t cell) : cpu(parent.cpu, cell) {}
+
   /**
    * Sets the points in the OrgState to the specified value through the CPU
    * 
    * @param _in the desired number of points
    */
-  void SetPoints(double _in) { cpu.state.points = _in; }
+  void SetPoints(double _in) { cpu.state.SetPoints(_in); }
 
   /**
    * Adds the specified number of points to the OrgState through the CPU
    * 
    * @param _in the number of points to add
    */
-  void AddPoints(double _in) { cpu.state.points += _in; }
+  void AddPoints(double _in) { cpu.state.AddPoints(_in); }
 
   /**
    * Accesses the organism's points through the CPU
    * 
    * @return the organism's points
    */
-  double GetPoints() { return cpu.state.points; }
+  double GetPoints() const { return cpu.state.GetPoints(); }
 
   /**
    * Calls the CPU's Reset function
@@ -45,32 +67,54 @@ public:
   void Mutate() { cpu.Mutate(); }
 
   /**
-   * Accesses the organism's CPU
+   * Accesses the organism's CPU without copying it
    * 
-   * @return the CPU
+   * @return a const reference to the CPU
    */
-  CPU getCPU() { return cpu; }
+  const CPU<Spec> &getCPU() const { return cpu; }
 
   /**
-   * Attempt to produce a child organism, if this organism has enough points.
+   * Accesses the organism's state without copying the CPU or genome
+   * 
+   * @return a const reference to the OrgState
    */
-  std::optional<Organism> CheckReproduction() {
-    Organism offspring = *this;
-    offspring.Reset();
-    offspring.Mutate();
-    return offspring;
-    return {};
-  }
+  const OrgState &GetState() const { return cpu.state; }
+
+  /**
+   * Turns this organism into a mutated offspring of the parent, reusing this
+   * organism's CPU and genome buffers.
+   * 
+   * @param parent the organism to inherit the genome from; may be this organism
+   */
+  void InheritFrom(const Organism &parent) { cpu.InheritFrom(parent.cpu); }
+
+  /**
+   * Writes the organism's genome and execution state to a checkpoint.
+   * 
+   * @param out the checkpoint stream
+   */
+  void Save(std::ostream &out) { cpu.Save(out); }
 
   /**
    * Uses the necessary CPU functionality to process an organism.
+   *
+   * @param rng_key the key of this cell's input stream for the current update
+   * @param n_cycles how many CPU cycles to run this update
    */
-  void Process(emp::WorldPosition current_location) {
+  void Process(uint64_t rng_key, size_t n_cycles) {
     //cpu.state.task_done = false;
-    cpu.state.current_location = current_location;
-    cpu.RunCPUStep(10);
+    cpu.state.rng.Reset(rng_key);
+    cpu.RunCPUStep(n_cycles);
   }
 
+  /**
+   * Checks whether the organism's CPU can never act again, so that the world
+   * skips running it when it skips dormant organisms.
+   *
+   * @return whether the CPU has been found dormant
+   */
+  bool IsDormant() const { return cpu.IsDormant(); }
+
   /**
    * Prints the organism's genome using its CPU.
    */
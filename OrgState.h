@@ -1,44 +1,80 @@
 #ifndef ORGSTATE_H
 #define ORGSTATE_H
 
-#include "emp/Evolve/World_structure.hpp"
+#include "emp/base/Ptr.hpp"
+#include "CounterRandom.h"
+#include "OrgStateStore.h"
+#include <algorithm>
 #include <cstddef>
+#include <cstdint>
 
 // This forward declaration is necessary since the world contains organisms,
 // which contain cpus, which contain the state, so if the state could actually
-// access the definition of the world there would be a cycle.
-class OrgWorld;
+// access the definition of the world there would be a cycle. The state points
+// at the part of the world that does not depend on the instruction set.
+class OrgWorldBase;
 
+// OrgState::local_anchor_idx of a core whose local jump table is still the one
+// it was launched with
+constexpr uint64_t LAUNCH_LOCAL_ANCHORS = UINT64_MAX;
+
+/**
+ * The handle an organism's instructions use to reach its task state. The
+ * values themselves live in the world's OrgStateStore at the organism's cell.
+ */
 struct OrgState {
-  emp::Ptr<OrgWorld> world;
-
-  //Array for tracking the four most recent input values
-  uint32_t last_inputs[4];
-  //Index of the most recent input value in array
-  size_t last_input_idx;
-  //How many points this organism has currently
-  double points;
-  //Needs to know current location for possible reproduction
-  emp::WorldPosition current_location;
-  //Booleans indicating task completion by the organism
-  bool doneNOT;
-  bool doneNAND;
-  bool doneAND;
-  bool doneORN;
-  bool doneOR;
-  bool doneANDN;
-  bool doneNOR;
-  bool doneXOR;
-  bool doneEQU;
+  emp::Ptr<OrgWorldBase> world;
+  //The world's state arrays, which this organism's values are stored in
+  emp::Ptr<OrgStateStore> store;
+  //The cell this organism occupies, and so its index in the store
+  size_t cell;
+  //Random stream for new inputs, keyed on (seed, update, cell) by the world
+  CounterRandom rng;
+  //IO instructions and successful Reproduce instructions executed, which the
+  //CPU's dormancy check watches for
+  uint32_t actions = 0;
+  //Program counter the active core's local jump table was last loaded at by a
+  //global jump, which fixes where local jumps go
+  uint64_t local_anchor_idx = LAUNCH_LOCAL_ANCHORS;
+
+  double GetPoints() const { return store->points[cell]; }
+  void SetPoints(double _points) { store->points[cell] = _points; }
+  void AddPoints(double _points) { store->points[cell] += _points; }
 
+  uint32_t GetTasksDone() const { return store->tasks_done[cell]; }
+  void SetTasksDone(uint32_t tasks) { store->tasks_done[cell] = tasks; }
+
+  /**
+  * Checks whether the organism has completed a task
+  */
+  bool IsDone(size_t task) const { return (GetTasksDone() >> task) & 1; }
+
+  /**
+  * Returns the INPUT_WINDOW most recent input values
+  */
+  uint32_t *GetInputs() { return store->inputs.data() + cell * INPUT_WINDOW; }
+  const uint32_t *GetInputs() const { return store->inputs.data() + cell * INPUT_WINDOW; }
+
+  uint8_t GetInputIdx() const { return store->input_idx[cell]; }
+  void SetInputIdx(uint8_t idx) { store->input_idx[cell] = idx; }
+
+  /**
+  * Replaces the whole input window, keeping the precomputed task candidates in step
+  */
+  void SetInputs(const uint32_t *values) {
+    std::copy_n(values, INPUT_WINDOW, GetInputs());
+    store->RebuildCandidates(cell);
+  }
 
   /**
-  * Adds an input number to the tracker
+  * Adds an input number to the tracker, recomputing only the task candidates that read it
   */
   void add_input(uint32_t input) {
-    last_inputs[last_input_idx] = input;
-    last_input_idx = (last_input_idx + 1) % 4;
+    uint8_t &idx = store->input_idx[cell];
+    GetInputs()[idx] = input;
+    store->UpdateCandidates(cell, idx);
+    idx = (idx + 1) % INPUT_WINDOW;
   }
 };
 
-#endif
\ No newline at end of file
+#endif
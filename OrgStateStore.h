@@ -0,0 +1,110 @@
+#ifndef ORG_STATE_STORE_H
+#define ORG_STATE_STORE_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Task.h"
+
+/**
+ * The task state of every organism in a world, stored as one contiguous array
+ * per field and indexed by cell. Whole-population passes such as the census,
+ * the merit scheduler and rendering read a single dense array instead of
+ * visiting every organism on the heap. Entries for empty cells are zero, apart
+ * from the task candidates, which are those of an all-zero input window.
+ */
+struct OrgStateStore {
+  // How many points each organism has currently
+  std::vector<double> points;
+  // Bitmask of tasks completed by each organism, bit i set for TaskId i
+  std::vector<uint32_t> tasks_done;
+  // INPUT_WINDOW most recent input values per cell, cell-major
+  std::vector<uint32_t> inputs;
+  // Index of the slot the next input is written to, per cell
+  std::vector<uint8_t> input_idx;
+  // The output passing each of TASK_CHECKS on the current inputs, per cell, cell-major
+  std::vector<uint32_t> candidates;
+
+  // Bytes stored for each cell, for memory estimates
+  static constexpr size_t BYTES_PER_CELL =
+      sizeof(double) + sizeof(uint32_t) + INPUT_WINDOW * sizeof(uint32_t) + sizeof(uint8_t) +
+      NUM_TASK_CHECKS * sizeof(uint32_t);
+
+  /**
+   * Input: A cell index and the window slot its latest input was written to
+   *
+   * Output: None
+   *
+   * Purpose: Recomputes the cell's candidates that read the slot.
+   */
+  void UpdateCandidates(size_t cell, size_t slot) {
+    ::UpdateCandidates(slot, &candidates[cell * NUM_TASK_CHECKS], &inputs[cell * INPUT_WINDOW]);
+  }
+
+  /**
+   * Input: A cell index
+   *
+   * Output: None
+   *
+   * Purpose: Recomputes every candidate of the cell, after its whole input
+   * window has been replaced.
+   */
+  void RebuildCandidates(size_t cell) {
+    for (size_t check = 0; check < NUM_TASK_CHECKS; check++) {
+      candidates[cell * NUM_TASK_CHECKS + check] =
+          CheckCandidate(TASK_CHECKS[check], &inputs[cell * INPUT_WINDOW]);
+    }
+  }
+
+  /**
+   * Input: A cell index and an output its organism produced
+   *
+   * Output: A bitmask with bit TaskId set for every task the output performs,
+   * the same as EvaluateTasks() on the cell's inputs
+   *
+   * Purpose: Scores an output against the cell's precomputed candidates.
+   */
+  uint32_t MatchOutput(size_t cell, uint32_t output) const {
+    return MatchCandidates(&candidates[cell * NUM_TASK_CHECKS], output);
+  }
+
+  /**
+   * Input: The number of cells in the world
+   *
+   * Output: None
+   *
+   * Purpose: Sizes every array to the world, zeroing any new entries; the
+   * candidates of new cells are those of an all-zero input window.
+   */
+  void Resize(size_t num_cells) {
+    points.resize(num_cells, 0.0);
+    tasks_done.resize(num_cells, 0);
+    inputs.resize(num_cells * INPUT_WINDOW, 0);
+    input_idx.resize(num_cells, 0);
+    const size_t old_cells = candidates.size() / NUM_TASK_CHECKS;
+    candidates.resize(num_cells * NUM_TASK_CHECKS, 0);
+    for (size_t cell = old_cells; cell < num_cells; cell++) {
+      RebuildCandidates(cell);
+    }
+  }
+
+  /**
+   * Input: A cell index
+   *
+   * Output: None
+   *
+   * Purpose: Resets a cell's entries, when its organism dies or is replaced.
+   * The candidates are those of an all-zero input window.
+   */
+  void Clear(size_t cell) {
+    points[cell] = 0.0;
+    tasks_done[cell] = 0;
+    std::fill_n(inputs.begin() + cell * INPUT_WINDOW, INPUT_WINDOW, 0);
+    input_idx[cell] = 0;
+    RebuildCandidates(cell);
+  }
+};
+
+#endif
@@ -0,0 +1,117 @@
+#ifndef ORG_WORLD_BASE_H
+#define ORG_WORLD_BASE_H
+
+#include "emp/base/Ptr.hpp"
+#include "emp/base/vector.hpp"
+
+#include "OrgState.h"
+#include "OrgStateStore.h"
+#include "ResourceGrid.h"
+#include "Stats.h"
+#include "Task.h"
+
+/**
+ * The part of the world that organisms call back into while executing. It does not
+ * depend on the instruction set, so OrgState can point at it whichever set a world uses.
+ */
+class OrgWorldBase {
+protected:
+  // Reproduce instructions executed by each cell this update; each cell only
+  // writes its own entry, so threads never contend for it
+  emp::vector<uint32_t> reproduce_requests;
+  // Task state of every organism, indexed by cell
+  OrgStateStore states;
+  bool reward;
+  // Per-task resources that scale task rewards, null unless enabled
+  emp::Ptr<ResourceGrid> resources;
+  // Whether executing organisms count IO calls and task hits in execution_counters
+  bool instrumented = false;
+  // Whether organisms whose CPUs can never act again stop being run
+  bool skip_dormant = false;
+
+public:
+  void SetReward(bool rewardBool) { reward = rewardBool; }
+
+  bool GetReward() { return reward; }
+
+  bool GetSkipDormant() const { return skip_dormant; }
+
+  /**
+   * @brief Returns the task state arrays of the whole population, indexed by cell.
+   *
+   * @return OrgStateStore& The store organisms' states point into.
+   */
+  OrgStateStore &GetStates() { return states; }
+  const OrgStateStore &GetStates() const { return states; }
+
+  /**
+   * @brief Evaluates a given output against all tasks and updates the organism's state.
+   *
+   * This function scores the output against all nine tasks by looking it up in the cell's
+   * task candidates, which were precomputed as its inputs arrived and give the same bitmask
+   * of tasks performed as EvaluateTasks. Depending on the value of the reward
+   * parameter, the points for that bitmask are looked up from either the reward-all table,
+   * where every completed task earns its reward, or the reward-none table, where only EQU
+   * does. With resources enabled, the bonus of each paying task, its reward above the
+   * failure points, is scaled by the share the task's resource in the organism's cell
+   * pays, which also uses some of the resource up; a depleted task still earns the
+   * failure points, as if it had not been performed. The bitmask is then merged into the organism's completed tasks. When the
+   * world is instrumented the call and each task performed are also counted.
+   *
+   * @param reward A boolean value indicating reward-all or reward-none condition.
+   * @param output The output value produced by an organism.
+   * @param state The current state of the organism that will be updated based on the task outcomes.
+   */
+  void CheckOutput(bool reward, uint32_t output, OrgState &state) {
+    const uint32_t done = states.MatchOutput(state.cell, output);
+    double earned = reward ? TASK_POINTS.all[done] : TASK_POINTS.equ_only[done];
+    if (resources && done) {
+      for (size_t task = 0; task < NUM_TASKS; task++) {
+        if (((done >> task) & 1) && (reward || task == TASK_EQU)) {
+          earned -= (TASK_REWARDS[task] - TASK_FAIL_POINTS) *
+                    (1.0 - resources->Consume(task, state.cell));
+        }
+      }
+    }
+    states.points[state.cell] += earned;
+    states.tasks_done[state.cell] |= done;
+    if (instrumented) {
+      execution_counters.io_calls++;
+      for (size_t task = 0; task < NUM_TASKS; task++) {
+        execution_counters.task_hits[task] += (done >> task) & 1;
+      }
+    }
+  }
+
+  /**
+   * @brief Queues an organism for reproduction at a specified world location.
+   *
+   * This function records a reproduction request for the provided cell. Reproduction is
+   * delayed until after all organisms have been processed, avoiding potential conflicts such as
+   * a child organism overwriting its parent during the same update cycle.
+   *
+   * @param cell The cell of the organism that will reproduce.
+   */
+  void ReproduceOrg(size_t cell) {
+    reproduce_requests[cell]++;
+  }
+};
+
+/**
+ * A world of a single cell, for running one organism in isolation, such as to trace
+ * a genotype. Reproduction requests are counted but nothing is ever born, and task
+ * rewards are never scaled by resources.
+ */
+class Sandbox : public OrgWorldBase {
+public:
+  /**
+   * @param _reward Whether every task receives its reward, as in the world being studied.
+   */
+  explicit Sandbox(bool _reward) {
+    reward = _reward;
+    states.Resize(1);
+    reproduce_requests.assign(1, 0);
+  }
+};
+
+#endif
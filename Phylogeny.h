@@ -0,0 +1,181 @@
+#ifndef PHYLOGENY_H
+#define PHYLOGENY_H
+
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "Task.h"
+
+/**
+ * A pruned phylogeny of genotypes. A taxon is a run of organisms with the same
+ * genome: an offspring joins its parent's taxon unless mutation changed its
+ * genome, in which case it founds a child taxon. Only taxa with living
+ * organisms, and their ancestors, are kept; a taxon is pruned as soon as it
+ * has neither, which in turn may prune its parent.
+ *
+ * Taxa live in a single arena vector and freed slots are reused, so tracking
+ * does not allocate once the arena has grown to the size of the phylogeny.
+ */
+class Phylogeny {
+public:
+  // Arena index meaning "no taxon"
+  static constexpr uint32_t NONE = UINT32_MAX;
+
+  struct Taxon {
+    // Unique over the whole run, unlike the arena index, which is reused
+    uint64_t id;
+    // Arena index of the parent taxon, NONE for ancestors
+    uint32_t parent;
+    // Living organisms in this taxon
+    uint32_t num_orgs;
+    // Child taxa still in the phylogeny
+    uint32_t num_children;
+    uint32_t origin_update;
+    // Bitmask of tasks performed by any organism of this taxon, by TaskId
+    uint32_t tasks;
+  };
+
+private:
+  std::vector<Taxon> taxa;
+  std::vector<uint32_t> free_slots;
+  uint64_t next_id = 0;
+  size_t num_taxa = 0;
+
+  uint32_t NewTaxon(uint32_t parent, size_t update) {
+    uint32_t slot;
+    if (free_slots.empty()) {
+      slot = taxa.size();
+      taxa.emplace_back();
+    } else {
+      slot = free_slots.back();
+      free_slots.pop_back();
+    }
+    taxa[slot] = Taxon{next_id++, parent, 0, 0, static_cast<uint32_t>(update), 0};
+    num_taxa++;
+    return slot;
+  }
+
+  /**
+   * Input: An arena index
+   *
+   * Output: None
+   *
+   * Purpose: Frees the taxon and any ancestors left without living
+   * organisms or descendants.
+   */
+  void Prune(uint32_t taxon) {
+    while (taxon != NONE && taxa[taxon].num_orgs == 0 && taxa[taxon].num_children == 0) {
+      const uint32_t parent = taxa[taxon].parent;
+      free_slots.push_back(taxon);
+      num_taxa--;
+      if (parent != NONE) {
+        taxa[parent].num_children--;
+      }
+      taxon = parent;
+    }
+  }
+
+public:
+  /**
+   * Input: The current update
+   *
+   * Output: The arena index of a new ancestral taxon
+   *
+   * Purpose: Starts a lineage for an organism placed without a parent.
+   */
+  uint32_t AddRoot(size_t update) { return NewTaxon(NONE, update); }
+
+  /**
+   * Input: The parent taxon and the current update
+   *
+   * Output: The arena index of a new taxon descended from the parent
+   *
+   * Purpose: Records a new genotype arising by mutation.
+   */
+  uint32_t AddChild(uint32_t parent, size_t update) {
+    const uint32_t child = NewTaxon(parent, update);
+    taxa[parent].num_children++;
+    return child;
+  }
+
+  /** Counts a newly placed organism towards its taxon. */
+  void AddOrg(uint32_t taxon) { taxa[taxon].num_orgs++; }
+
+  /**
+   * Input: A taxon and the tasks one of its organisms performed
+   *
+   * Output: None
+   *
+   * Purpose: Merges the organism's tasks into the taxon's.
+   */
+  void RecordTasks(uint32_t taxon, uint32_t tasks_done) { taxa[taxon].tasks |= tasks_done; }
+
+  /**
+   * Input: The taxon of an organism that died and the tasks it performed
+   *
+   * Output: None
+   *
+   * Purpose: Records the organism's tasks and prunes the taxon if it has no
+   * organisms or descendants left.
+   */
+  void RemoveOrg(uint32_t taxon, uint32_t tasks_done) {
+    RecordTasks(taxon, tasks_done);
+    taxa[taxon].num_orgs--;
+    Prune(taxon);
+  }
+
+  /** The number of taxa currently in the phylogeny. */
+  size_t GetNumTaxa() const { return num_taxa; }
+
+  const Taxon &GetTaxon(uint32_t taxon) const { return taxa[taxon]; }
+
+  /**
+   * Input: The file to write
+   *
+   * Output: Whether the file was written
+   *
+   * Purpose: Writes every taxon in the phylogeny as comma-separated text, one
+   * row per taxon with its id, its parent's id (-1 for ancestors), the update
+   * it arose at, its living organisms, and the tasks it has performed as a
+   * bitmask by TaskId and by name.
+   */
+  bool WriteSnapshot(const std::string &filename) const {
+    std::ofstream out(filename);
+    if (!out) {
+      std::cerr << "Could not open phylogeny file " << filename << std::endl;
+      return false;
+    }
+    out << "id,parent_id,origin_update,num_orgs,tasks_mask,tasks\n";
+    std::vector<bool> is_free(taxa.size(), false);
+    for (uint32_t slot : free_slots) {
+      is_free[slot] = true;
+    }
+    for (size_t slot = 0; slot < taxa.size(); slot++) {
+      if (is_free[slot]) {
+        continue;
+      }
+      const Taxon &taxon = taxa[slot];
+      out << taxon.id << ',';
+      if (taxon.parent == NONE) {
+        out << -1;
+      } else {
+        out << taxa[taxon.parent].id;
+      }
+      out << ',' << taxon.origin_update << ',' << taxon.num_orgs << ',' << taxon.tasks << ',';
+      bool first = true;
+      for (size_t task = 0; task < NUM_TASKS; task++) {
+        if ((taxon.tasks >> task) & 1) {
+          out << (first ? "" : " ") << TASK_NAMES[task];
+          first = false;
+        }
+      }
+      out << '\n';
+    }
+    return true;
+  }
+};
+
+#endif
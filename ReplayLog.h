@@ -0,0 +1,174 @@
+#ifndef REPLAY_LOG_H
+#define REPLAY_LOG_H
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/**
+ * The replay log format: after every update, hashes of the random number
+ * generators' states and of every cell, so two runs that should be identical
+ * can be compared to find the first update and cell where they differ.
+ *
+ * Layout, all integers little-endian:
+ *   header:
+ *     char[8]   magic "ORGRPLY1"
+ *     uint32    version (1)
+ *     uint32    reserved (0)
+ *   one record per update:
+ *     uint64    update the record was taken after
+ *     uint64    hash of the world's emp::Random state
+ *     uint64    hash of the sgpl::tlrand state of the thread running births
+ *     uint64    hash of the whole population, combining the cell hashes
+ *     uint32    grid width
+ *     uint32    number of cells
+ *     uint32    hash of each cell, 0 for empty cells
+ */
+struct ReplayLayout {
+  static constexpr char MAGIC[8] = {'O', 'R', 'G', 'R', 'P', 'L', 'Y', '1'};
+  static constexpr uint32_t VERSION = 1;
+  static constexpr size_t HEADER_SIZE = 16;
+  static constexpr size_t RECORD_HEADER_SIZE = 40;
+};
+
+/**
+ * One update's worth of hashes.
+ */
+struct ReplayRecord {
+  uint64_t update = 0;
+  uint64_t world_random = 0;
+  uint64_t sgpl_random = 0;
+  uint64_t population = 0;
+  uint32_t width = 0;
+  std::vector<uint32_t> cells;
+};
+
+/**
+ * Reads a replay log written by ReplayLogWriter one record at a time, so logs
+ * of any length can be compared in constant memory.
+ */
+class ReplayLogReader {
+  std::ifstream file;
+  std::vector<char> buffer;
+  bool valid = false;
+
+  uint64_t GetLE(size_t offset, size_t num_bytes) const {
+    uint64_t value = 0;
+    for (size_t i = 0; i < num_bytes; i++) {
+      value |= static_cast<uint64_t>(static_cast<unsigned char>(buffer[offset + i])) << (8 * i);
+    }
+    return value;
+  }
+
+  bool ReadBytes(size_t num_bytes) {
+    buffer.resize(num_bytes);
+    file.read(buffer.data(), num_bytes);
+    return static_cast<size_t>(file.gcount()) == num_bytes;
+  }
+
+public:
+  /**
+   * Opens the file and validates its header. Check IsValid() before reading
+   * records.
+   */
+  explicit ReplayLogReader(const std::string &filename) : file(filename, std::ios::binary) {
+    valid = ReadBytes(ReplayLayout::HEADER_SIZE) &&
+            !std::memcmp(buffer.data(), ReplayLayout::MAGIC, sizeof(ReplayLayout::MAGIC)) &&
+            GetLE(8, 4) == ReplayLayout::VERSION;
+  }
+
+  bool IsValid() const { return valid; }
+
+  /**
+   * Input: The record to fill, whose cell vector is reused
+   *
+   * Output: Whether a whole record was read
+   *
+   * Purpose: Reads the next record. A record cut off at the end of the file,
+   * as left by a run that was killed, counts as the end of the log.
+   */
+  bool Next(ReplayRecord &record) {
+    if (!valid || !ReadBytes(ReplayLayout::RECORD_HEADER_SIZE)) {
+      return false;
+    }
+    record.update = GetLE(0, 8);
+    record.world_random = GetLE(8, 8);
+    record.sgpl_random = GetLE(16, 8);
+    record.population = GetLE(24, 8);
+    record.width = GetLE(32, 4);
+    const size_t num_cells = GetLE(36, 4);
+    if (!ReadBytes(num_cells * 4)) {
+      return false;
+    }
+    record.cells.resize(num_cells);
+    for (size_t cell = 0; cell < num_cells; cell++) {
+      record.cells[cell] = GetLE(cell * 4, 4);
+    }
+    return true;
+  }
+};
+
+/**
+ * Writes replay records in the format described by ReplayLayout. Each record
+ * is assembled in memory and written with a single call.
+ */
+class ReplayLogWriter : private ReplayLayout {
+  std::ofstream file;
+  std::string buffer;
+
+  void PutLE(uint64_t value, size_t num_bytes) {
+    for (size_t i = 0; i < num_bytes; i++) {
+      buffer.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+    }
+  }
+
+public:
+  /**
+   * Creates the file and writes its header. Check IsOpen() afterwards.
+   */
+  explicit ReplayLogWriter(const std::string &filename)
+      : file(filename, std::ios::binary | std::ios::trunc) {
+    if (!file) {
+      std::cerr << "Could not open replay log " << filename << std::endl;
+      return;
+    }
+    file.write(MAGIC, sizeof(MAGIC));
+    PutLE(VERSION, 4);
+    PutLE(0, 4);
+    file.write(buffer.data(), buffer.size());
+    buffer.clear();
+  }
+
+  ReplayLogWriter(const ReplayLogWriter &) = delete;
+  ReplayLogWriter &operator=(const ReplayLogWriter &) = delete;
+
+  bool IsOpen() const { return static_cast<bool>(file); }
+
+  /**
+   * Input: One update's hashes
+   *
+   * Output: None
+   *
+   * Purpose: Appends a record. The file is flushed so that a run that crashes
+   * still leaves every finished update in the log.
+   */
+  void Write(const ReplayRecord &record) {
+    buffer.clear();
+    PutLE(record.update, 8);
+    PutLE(record.world_random, 8);
+    PutLE(record.sgpl_random, 8);
+    PutLE(record.population, 8);
+    PutLE(record.width, 4);
+    PutLE(record.cells.size(), 4);
+    for (uint32_t cell : record.cells) {
+      PutLE(cell, 4);
+    }
+    file.write(buffer.data(), buffer.size());
+    file.flush();
+  }
+};
+
+#endif
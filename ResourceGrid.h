@@ -0,0 +1,135 @@
+#ifndef RESOURCE_GRID_H
+#define RESOURCE_GRID_H
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+#include "Task.h"
+
+/**
+ * How the resources of a ResourceGrid flow, all per update.
+ */
+struct ResourceSettings {
+  // Amount of each task's resource added to every cell
+  float inflow = 1.0f;
+  // Fraction of every cell's resource that drains away; must be positive
+  float outflow = 0.01f;
+  // Fraction of a cell's resource that spreads to each of its four neighbors, at most 0.25
+  float diffusion = 0.1f;
+  // Fraction of its cell's resource a task uses up each time it is performed
+  float uptake = 0.01f;
+};
+
+/**
+ * A depletable resource per task on every cell of a toroidal grid. Performing a
+ * task uses up part of that task's resource in the organism's cell, and the
+ * reward is scaled by how much was available, so a task many neighbors are
+ * already performing pays less. Every update the resources diffuse to the four
+ * neighboring cells, drain away, and are replenished; without consumption
+ * every cell settles at inflow / outflow, where tasks pay their full reward.
+ *
+ * Each task's levels are one dense array of floats in cell order, and the
+ * update is a five-point stencil whose inner loop over a row is contiguous so
+ * compilers vectorize it.
+ */
+class ResourceGrid {
+  ResourceSettings settings;
+  size_t width = 0;
+  size_t height = 0;
+  // Levels of task t occupy [t * width * height, (t + 1) * width * height)
+  std::vector<float> levels;
+  // Scratch buffer the stencil writes into, swapped with levels afterwards
+  std::vector<float> next_levels;
+
+  float Equilibrium() const { return settings.inflow / settings.outflow; }
+
+  /**
+   * Input: The levels of one task before and after the update
+   *
+   * Output: None
+   *
+   * Purpose: Applies diffusion, drain and inflow to one task's resource.
+   */
+  void UpdateField(const float *in, float *out) const {
+    const float center = 1.0f - 4.0f * settings.diffusion;
+    const float spread = settings.diffusion;
+    const float keep = 1.0f - settings.outflow;
+    const float inflow = settings.inflow;
+    auto cell = [&](size_t y, size_t x, size_t north, size_t south) {
+      const size_t west = x ? x - 1 : width - 1;
+      const size_t east = x + 1 < width ? x + 1 : 0;
+      const float neighbors =
+          in[north + x] + in[south + x] + in[y + west] + in[y + east];
+      return (center * in[y + x] + spread * neighbors) * keep + inflow;
+    };
+    for (size_t row = 0; row < height; row++) {
+      const size_t y = row * width;
+      const size_t north = (row ? row - 1 : height - 1) * width;
+      const size_t south = (row + 1 < height ? row + 1 : 0) * width;
+      out[y] = cell(y, 0, north, south);
+      for (size_t x = 1; x + 1 < width; x++) {
+        const float neighbors = in[north + x] + in[south + x] + in[y + x - 1] + in[y + x + 1];
+        out[y + x] = (center * in[y + x] + spread * neighbors) * keep + inflow;
+      }
+      if (width > 1) {
+        out[y + width - 1] = cell(y, width - 1, north, south);
+      }
+    }
+  }
+
+public:
+  explicit ResourceGrid(const ResourceSettings &_settings) : settings(_settings) {}
+
+  /**
+   * Input: The grid's width and height
+   *
+   * Output: None
+   *
+   * Purpose: Sizes the grid and fills every cell with its equilibrium level.
+   */
+  void Resize(size_t _width, size_t _height) {
+    width = _width;
+    height = _height;
+    levels.assign(NUM_TASKS * width * height, Equilibrium());
+    next_levels.assign(levels.size(), 0.0f);
+  }
+
+  /**
+   * Input: A task and the cell it was performed in
+   *
+   * Output: The share of the task's full reward the cell's resource pays:
+   * the level before consuming relative to equilibrium, so 1 at equilibrium
+   *
+   * Purpose: Uses up part of the resource. Only touches the given cell, so
+   * organisms in different cells can consume concurrently.
+   */
+  double Consume(size_t task, size_t cell) {
+    float &level = levels[task * width * height + cell];
+    const float before = level;
+    level -= settings.uptake * before;
+    return before / Equilibrium();
+  }
+
+  /**
+   * Input: None
+   *
+   * Output: None
+   *
+   * Purpose: Advances every task's resource by one update.
+   */
+  void Update() {
+    const size_t num_cells = width * height;
+    for (size_t task = 0; task < NUM_TASKS; task++) {
+      UpdateField(&levels[task * num_cells], &next_levels[task * num_cells]);
+    }
+    std::swap(levels, next_levels);
+  }
+
+  float GetLevel(size_t task, size_t cell) const { return levels[task * width * height + cell]; }
+
+  /** Every level, task-major, for checkpointing. */
+  std::vector<float> &GetLevels() { return levels; }
+};
+
+#endif
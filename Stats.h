@@ -0,0 +1,179 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <ostream>
+
+#include "Task.h"
+
+/**
+ * Counters bumped while organisms execute. Each thread has its own copy,
+ * which the world zeroes before handing the thread organisms and merges into
+ * its update statistics afterwards, so counting needs no atomics.
+ */
+struct ExecutionCounters {
+  uint64_t cycles = 0;
+  // Cycles handed to dormant organisms, which were not run
+  uint64_t dormant_cycles = 0;
+  uint64_t io_calls = 0;
+  // Outputs that performed each task, by TaskId
+  std::array<uint64_t, NUM_TASKS> task_hits{};
+};
+
+inline thread_local ExecutionCounters execution_counters;
+
+/**
+ * Timings and counters of the update loop, summed over some number of updates.
+ * Phase times are in nanoseconds. The base update includes the census and the
+ * data file writes, which run as update callbacks and are also reported on
+ * their own.
+ */
+struct UpdateStats {
+  uint64_t updates = 0;
+  uint64_t base_ns = 0;
+  uint64_t census_ns = 0;
+  uint64_t file_ns = 0;
+  uint64_t process_ns = 0;
+  uint64_t birth_ns = 0;
+  uint64_t resource_ns = 0;
+  uint64_t cycles = 0;
+  uint64_t dormant_cycles = 0;
+  uint64_t io_calls = 0;
+  uint64_t births = 0;
+  // Summed over updates; divide by updates for the mean
+  uint64_t queue_length = 0;
+  uint64_t max_queue_length = 0;
+  std::array<uint64_t, NUM_TASKS> task_hits{};
+
+  /**
+   * Input: One thread's execution counters
+   *
+   * Output: None
+   *
+   * Purpose: Merges counters gathered while processing organisms.
+   */
+  void AddCounters(const ExecutionCounters &counters) {
+    cycles += counters.cycles;
+    dormant_cycles += counters.dormant_cycles;
+    io_calls += counters.io_calls;
+    for (size_t task = 0; task < NUM_TASKS; task++) {
+      task_hits[task] += counters.task_hits[task];
+    }
+  }
+
+  /**
+   * Input: Statistics over other updates
+   *
+   * Output: None
+   *
+   * Purpose: Accumulates an interval into a run total.
+   */
+  void Add(const UpdateStats &other) {
+    updates += other.updates;
+    base_ns += other.base_ns;
+    census_ns += other.census_ns;
+    file_ns += other.file_ns;
+    process_ns += other.process_ns;
+    birth_ns += other.birth_ns;
+    resource_ns += other.resource_ns;
+    cycles += other.cycles;
+    dormant_cycles += other.dormant_cycles;
+    io_calls += other.io_calls;
+    births += other.births;
+    queue_length += other.queue_length;
+    max_queue_length = std::max(max_queue_length, other.max_queue_length);
+    for (size_t task = 0; task < NUM_TASKS; task++) {
+      task_hits[task] += other.task_hits[task];
+    }
+  }
+
+  /**
+   * Input: The stream to write to and the update the interval ended at
+   *
+   * Output: None
+   *
+   * Purpose: Writes the statistics as a single line of JSON.
+   */
+  void WriteJson(std::ostream &out, size_t update) const {
+    out << "{\"update\": " << update << ", \"updates\": " << updates
+        << ", \"base_ns\": " << base_ns << ", \"census_ns\": " << census_ns
+        << ", \"file_ns\": " << file_ns << ", \"process_ns\": " << process_ns
+        << ", \"birth_ns\": " << birth_ns << ", \"resource_ns\": " << resource_ns
+        << ", \"cycles\": " << cycles << ", \"dormant_cycles\": " << dormant_cycles
+        << ", \"io_calls\": " << io_calls << ", \"births\": " << births
+        << ", \"queue_length\": " << queue_length
+        << ", \"max_queue_length\": " << max_queue_length << ", \"task_hits\": {";
+    for (size_t task = 0; task < NUM_TASKS; task++) {
+      out << (task ? ", " : "") << '"' << TASK_NAMES[task] << "\": " << task_hits[task];
+    }
+    out << "}}\n";
+  }
+
+  /**
+   * Input: The stream to write to
+   *
+   * Output: None
+   *
+   * Purpose: Prints a human-readable summary with per-update means and each
+   * phase's share of the measured time.
+   */
+  void PrintSummary(std::ostream &out) const {
+    const double n = updates ? static_cast<double>(updates) : 1.0;
+    const double total_ns = static_cast<double>(base_ns + process_ns + birth_ns + resource_ns);
+    auto phase = [&](const char *name, uint64_t ns) {
+      out << "  " << std::left << std::setw(14) << name << std::right << std::fixed
+          << std::setprecision(3) << std::setw(12) << ns / n / 1e6 << " ms/update"
+          << std::setprecision(1) << std::setw(8) << (total_ns ? 100.0 * ns / total_ns : 0.0)
+          << " %\n";
+    };
+    out << "Update loop over " << updates << " updates:\n";
+    phase("base update", base_ns);
+    phase("  census", census_ns);
+    phase("  file writes", file_ns);
+    phase("process", process_ns);
+    phase("births", birth_ns);
+    phase("resources", resource_ns);
+    out << std::setprecision(1) << "  cycles/update " << cycles / n << " (" << dormant_cycles / n
+        << " more skipped as dormant), IO calls/update "
+        << io_calls / n << ", births/update " << births / n << ", mean queue " << queue_length / n
+        << " (max " << max_queue_length << ")\n  task hits:";
+    for (size_t task = 0; task < NUM_TASKS; task++) {
+      out << ' ' << TASK_NAMES[task] << '=' << task_hits[task];
+    }
+    out << std::endl;
+  }
+};
+
+/**
+ * Adds the time until it goes out of scope to a phase counter. Constructed
+ * with a null counter it does nothing, not even read the clock, so timing
+ * points cost a branch when instrumentation is off.
+ */
+class PhaseTimer {
+  uint64_t *target;
+  std::chrono::steady_clock::time_point start;
+
+public:
+  explicit PhaseTimer(uint64_t *_target) : target(_target) {
+    if (target) {
+      start = std::chrono::steady_clock::now();
+    }
+  }
+
+  ~PhaseTimer() {
+    if (target) {
+      *target += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                     std::chrono::steady_clock::now() - start)
+                     .count();
+    }
+  }
+
+  PhaseTimer(const PhaseTimer &) = delete;
+  PhaseTimer &operator=(const PhaseTimer &) = delete;
+};
+
+#endif
@@ -2,399 +2,408 @@
 #define TASK_H
 
 //#include <_types/_uint32_t.h>
+#include <array>
 #include <cmath>
+#include <cstddef>
+#include <cstdint>
 #include <string>
 #include <iostream>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+// How many of the most recent inputs each organism remembers, and so how many
+// window slots the task checks below draw their inputs from. Fixed at compile
+// time: the task checks and candidate updates are unrolled over the slots, and
+// the state store and checkpoints lay out this many inputs per cell
+constexpr size_t INPUT_WINDOW = 4;
 
 /**
- * The interface for a task that organisms can complete.
+ * The tasks organisms can be rewarded for. Each is a type with its name, the
+ * points it is worth, how many inputs its logic function takes, and the
+ * function itself, which gets the inputs in the order the task takes them.
+ * Inputs past the task's arity repeat the first one and should be ignored.
  */
-class Task {
-public:
-  /**
-   * Given the output value the organism produced, and the last four inputs it
-   * received, this function returns the points the organism should get for
-   * completing this task (or 0 if the task was not completed.)
-   */
-  virtual double CheckOutput(uint32_t output, uint32_t inputs[4]) = 0;
+namespace tasks {
+
+struct EQU {
+  static constexpr const char *NAME = "EQU";
+  static constexpr double REWARD = 320.0;
+  static constexpr uint8_t ARITY = 2;
+  static constexpr uint32_t Output(uint32_t a, uint32_t b, uint32_t) { return ~(a ^ b); }
+};
+
+struct XOR {
+  static constexpr const char *NAME = "XOR";
+  static constexpr double REWARD = 161.0;
+  static constexpr uint8_t ARITY = 2;
+  static constexpr uint32_t Output(uint32_t a, uint32_t b, uint32_t) { return a ^ b; }
+};
+
+struct NOR {
+  static constexpr const char *NAME = "NOR";
+  static constexpr double REWARD = 160.0;
+  static constexpr uint8_t ARITY = 2;
+  static constexpr uint32_t Output(uint32_t a, uint32_t b, uint32_t) { return ~(a | b); }
+};
 
-  /** Returns the human-readable name of the task. */
-  virtual std::string name() const = 0;
+struct ANDN {
+  static constexpr const char *NAME = "ANDN";
+  static constexpr double REWARD = 81.0;
+  static constexpr uint8_t ARITY = 2;
+  static constexpr uint32_t Output(uint32_t a, uint32_t b, uint32_t) { return a & ~b; }
 };
 
-class NOT : public Task {
-
-    public:
-        /**
-         * @brief Evaluates the given output against the expected result based on the task's criterion.
-         *
-         * This function processes an organism's output by comparing it against values derived from the input array.
-         * A set larger value of points is rewarded if an organism succeeds in carrying out the logic task. This value is 
-         * proportional to the difficulty of carrying out that task. If the organism fails the task, it gets 1 point to
-         * allow it to still work towards reproducing.
-         *
-         * @param output The output value produced by an organism.
-         * @param inputs An array of input values used for evaluation.
-         * @return double The score awarded based on how closely the output matches the expected value.
-         */
-        double CheckOutput(uint32_t output, uint32_t inputs[4]) override {
-            // did they calculate NOT of a number?
-            for (int i = 0; i < 4; i++) {
-            uint32_t not_val = ~inputs[i]; //~ is bitwise NOT in C++
-                if (not_val == output) {
-                    // 10 points for success
-                    return 20.0;
-                }
-            }
-            // 0 points for failure
-            return 1.0;
-        }
-
-        /**
-         * @brief Returns the name of the task.
-         *
-         * This function provides a string identifier for the task, which can be used for logging, debugging, 
-         * or display purposes.
-         *
-         * @return std::string The name of the task.
-         */
-        std::string name() const override { return "NOT"; }
+struct OR {
+  static constexpr const char *NAME = "OR";
+  static constexpr double REWARD = 80.0;
+  static constexpr uint8_t ARITY = 2;
+  static constexpr uint32_t Output(uint32_t a, uint32_t b, uint32_t) { return a | b; }
 };
 
-class NAND : public Task {
-
-    public:
-        /**
-         * @brief Evaluates the given output against the expected result based on the task's criterion.
-         *
-         * This function processes an organism's output by comparing it against values derived from the input array.
-         * A set larger value of points is rewarded if an organism succeeds in carrying out the logic task. This value is 
-         * proportional to the difficulty of carrying out that task. If the organism fails the task, it gets 1 point to
-         * allow it to still work towards reproducing.
-         *
-         * @param output The output value produced by an organism.
-         * @param inputs An array of input values used for evaluation.
-         * @return double The score awarded based on how closely the output matches the expected value.
-         */
-        double CheckOutput(uint32_t output, uint32_t inputs[4]) override {
-            // did they calculate NOT of a number?
-            for (int i = 0; i < 3; i++) {
-                int plusOne = i + 1;
-                uint32_t val = inputs[i]; //~ is bitwise NOT in C++
-                uint32_t val_2 = inputs[plusOne];
-                uint32_t nand_val = ~(val & val_2);
-                if (nand_val == output) {
-                    // 10 points for success
-                    return 21.0;
-                }
-            }
-            // 0 points for failure
-            return 1.0;
-        }
-
-        /**
-         * @brief Returns the name of the task.
-         *
-         * This function provides a string identifier for the task, which can be used for logging, debugging, 
-         * or display purposes.
-         *
-         * @return std::string The name of the task.
-         */
-        std::string name() const override { return "NAND"; }
+struct ORN {
+  static constexpr const char *NAME = "ORN";
+  static constexpr double REWARD = 41.0;
+  static constexpr uint8_t ARITY = 2;
+  static constexpr uint32_t Output(uint32_t a, uint32_t b, uint32_t) { return a | ~b; }
 };
 
-class AND : public Task {
-
-    public:
-        /**
-         * @brief Evaluates the given output against the expected result based on the task's criterion.
-         *
-         * This function processes an organism's output by comparing it against values derived from the input array.
-         * A set larger value of points is rewarded if an organism succeeds in carrying out the logic task. This value is 
-         * proportional to the difficulty of carrying out that task. If the organism fails the task, it gets 1 point to
-         * allow it to still work towards reproducing.
-         *
-         * @param output The output value produced by an organism.
-         * @param inputs An array of input values used for evaluation.
-         * @return double The score awarded based on how closely the output matches the expected value.
-         */
-        double CheckOutput(uint32_t output, uint32_t inputs[4]) override {
-            // did they calculate NOT of a number?
-            for (int i = 0; i < 3; i++) {
-                int plusOne = i + 1;
-                uint32_t val = inputs[i]; //~ is bitwise NOT in C++
-                uint32_t val_2 = inputs[plusOne];
-                uint32_t and_val = val & val_2;
-                if (and_val == output) {
-                    // 10 points for success
-                    return 40.0;
-                }
-            // 0 points for failure
-            }
-            return 1.0;
-        }
-
-        /**
-         * @brief Returns the name of the task.
-         *
-         * This function provides a string identifier for the task, which can be used for logging, debugging, 
-         * or display purposes.
-         *
-         * @return std::string The name of the task.
-         */
-        std::string name() const override { return "AND"; }
+struct AND {
+  static constexpr const char *NAME = "AND";
+  static constexpr double REWARD = 40.0;
+  static constexpr uint8_t ARITY = 2;
+  static constexpr uint32_t Output(uint32_t a, uint32_t b, uint32_t) { return a & b; }
 };
 
-class ORN : public Task {
-
-    public:
-        /**
-         * @brief Evaluates the given output against the expected result based on the task's criterion.
-         *
-         * This function processes an organism's output by comparing it against values derived from the input array.
-         * A set larger value of points is rewarded if an organism succeeds in carrying out the logic task. This value is 
-         * proportional to the difficulty of carrying out that task. If the organism fails the task, it gets 1 point to
-         * allow it to still work towards reproducing.
-         *
-         * @param output The output value produced by an organism.
-         * @param inputs An array of input values used for evaluation.
-         * @return double The score awarded based on how closely the output matches the expected value.
-         */
-        double CheckOutput(uint32_t output, uint32_t inputs[4]) override {
-            // did they calculate NOT of a number?
-            for (int i = 0; i < 3; i++) {
-                int plusOne = i + 1;
-                uint32_t val = inputs[i]; //~ is bitwise NOT in C++
-                uint32_t val_2 = inputs[plusOne];
-                uint32_t orn_val = val | ~val_2;
-                if (orn_val == output) {
-                    // 10 points for success
-                    return 41.0;
-                }
-            // 0 points for failure
-            }
-            return 1.0;
-        }
-
-        /**
-         * @brief Returns the name of the task.
-         *
-         * This function provides a string identifier for the task, which can be used for logging, debugging, 
-         * or display purposes.
-         *
-         * @return std::string The name of the task.
-         */
-        std::string name() const override { return "ORN"; }
+struct NAND {
+  static constexpr const char *NAME = "NAND";
+  static constexpr double REWARD = 21.0;
+  static constexpr uint8_t ARITY = 2;
+  static constexpr uint32_t Output(uint32_t a, uint32_t b, uint32_t) { return ~(a & b); }
 };
 
-class OR : public Task {
-
-    public:
-        /**
-         * @brief Evaluates the given output against the expected result based on the task's criterion.
-         *
-         * This function processes an organism's output by comparing it against values derived from the input array.
-         * A set larger value of points is rewarded if an organism succeeds in carrying out the logic task. This value is 
-         * proportional to the difficulty of carrying out that task. If the organism fails the task, it gets 1 point to
-         * allow it to still work towards reproducing.
-         *
-         * @param output The output value produced by an organism.
-         * @param inputs An array of input values used for evaluation.
-         * @return double The score awarded based on how closely the output matches the expected value.
-         */
-        double CheckOutput(uint32_t output, uint32_t inputs[4]) override {
-            // did they calculate NOT of a number?
-            for (int i = 0; i < 3; i++) {
-                int plusOne = i + 1;
-                uint32_t val = inputs[i]; //~ is bitwise NOT in C++
-                uint32_t val_2 = inputs[plusOne];
-                uint32_t or_val = val | val_2;
-                if (or_val == output) {
-                    // 10 points for success
-                    return 80.0;
-                }
-            // 0 points for failure
-            }
-            return 1.0;
-        }
-
-        /**
-         * @brief Returns the name of the task.
-         *
-         * This function provides a string identifier for the task, which can be used for logging, debugging, 
-         * or display purposes.
-         *
-         * @return std::string The name of the task.
-         */
-        std::string name() const override { return "OR"; }
+struct NOT {
+  static constexpr const char *NAME = "NOT";
+  static constexpr double REWARD = 20.0;
+  static constexpr uint8_t ARITY = 1;
+  static constexpr uint32_t Output(uint32_t a, uint32_t, uint32_t) { return ~a; }
+};
+
+} // namespace tasks
+
+/**
+ * A set of task types fixed at compile time. A task's index is its position
+ * in the list, which is also its bit in task bitmasks; the per-task tables are
+ * generated from the types and every loop over the tasks is expanded at
+ * compile time, so each task's function is inlined with its bit as a constant.
+ */
+template <class... TASKS>
+struct TaskSet {
+  static constexpr size_t SIZE = sizeof...(TASKS);
+  static_assert(SIZE <= 16, "task bitmasks index tables of 2^SIZE entries");
+
+  static constexpr std::array<const char *, SIZE> NAMES{TASKS::NAME...};
+  static constexpr std::array<double, SIZE> REWARDS{TASKS::REWARD...};
+  static constexpr std::array<uint8_t, SIZE> ARITY{TASKS::ARITY...};
+
+  /** The task type at an index. */
+  template <size_t TASK>
+  using Type = std::tuple_element_t<TASK, std::tuple<TASKS...>>;
+
+  /** The index of a task type in the set. */
+  template <class TASK>
+  static constexpr size_t IndexOf() {
+    static_assert((std::is_same_v<TASK, TASKS> || ...), "task is not in the set");
+    size_t index = 0;
+    bool found = false;
+    ((found = found || std::is_same_v<TASK, TASKS>, index += !found), ...);
+    return index;
+  }
+
+  /**
+   * Input: A task index and up to three inputs, in the order the task takes them
+   *
+   * Output: The output that performs the task on those inputs
+   *
+   * Purpose: Dispatches to a task's logic function by index. With a constant
+   * index this folds to the function itself.
+   */
+  static constexpr uint32_t Output(size_t task, uint32_t a, uint32_t b, uint32_t c) {
+    return Output(task, a, b, c, std::index_sequence_for<TASKS...>{});
+  }
+
+  /**
+   * Input: An output and the last INPUT_WINDOW inputs
+   *
+   * Output: A bitmask with each task's bit set if the output performs it on
+   * some run of adjacent inputs
+   *
+   * Purpose: Scores an output directly. Every task and window position is
+   * expanded at compile time into branch-free compares.
+   */
+  static uint32_t Evaluate(uint32_t output, const uint32_t *inputs) {
+    return Evaluate(output, inputs, std::index_sequence_for<TASKS...>{});
+  }
+
+private:
+  template <size_t... I>
+  static constexpr uint32_t Output(size_t task, uint32_t a, uint32_t b, uint32_t c,
+                                   std::index_sequence<I...>) {
+    uint32_t output = 0;
+    ((task == I ? (output = TASKS::Output(a, b, c), 0) : 0), ...);
+    return output;
+  }
+
+  template <class TASK, size_t BIT, size_t... FIRST>
+  static uint32_t EvaluateTask(uint32_t output, const uint32_t *inputs,
+                               std::index_sequence<FIRST...>) {
+    return ((uint32_t(TASK::Output(inputs[FIRST], inputs[FIRST + (TASK::ARITY > 1)],
+                                   inputs[FIRST + 2 * (TASK::ARITY > 2)]) == output)
+             << BIT) |
+            ...);
+  }
+
+  template <size_t... I>
+  static uint32_t Evaluate(uint32_t output, const uint32_t *inputs, std::index_sequence<I...>) {
+    return (EvaluateTask<TASKS, I>(output, inputs,
+                                   std::make_index_sequence<INPUT_WINDOW + 1 - TASKS::ARITY>{}) |
+            ...);
+  }
 };
 
-class ANDN : public Task {
-
-    public:
-        /**
-         * @brief Evaluates the given output against the expected result based on the task's criterion.
-         *
-         * This function processes an organism's output by comparing it against values derived from the input array.
-         * A set larger value of points is rewarded if an organism succeeds in carrying out the logic task. This value is 
-         * proportional to the difficulty of carrying out that task. If the organism fails the task, it gets 1 point to
-         * allow it to still work towards reproducing.
-         *
-         * @param output The output value produced by an organism.
-         * @param inputs An array of input values used for evaluation.
-         * @return double The score awarded based on how closely the output matches the expected value.
-         */
-        double CheckOutput(uint32_t output, uint32_t inputs[4]) override {
-            // did they calculate NOT of a number?
-            for (int i = 0; i < 3; i++) {
-                int plusOne = i + 1;
-                uint32_t val = inputs[i]; //~ is bitwise NOT in C++
-                uint32_t val_2 = inputs[plusOne];
-                uint32_t andn_val = val & ~val_2;
-                if (andn_val == output) {
-                    // 10 points for success
-                    return 81.0;
-                }
-            // 0 points for failure
-            }
-            return 1.0;
-        }
-
-        /**
-         * @brief Returns the name of the task.
-         *
-         * This function provides a string identifier for the task, which can be used for logging, debugging, 
-         * or display purposes.
-         *
-         * @return std::string The name of the task.
-         */
-        std::string name() const override { return "ANDN"; }
+/**
+ * The tasks of the simulation, ordered from most to least difficult. This is
+ * the order in which task counts are reported in the data file. Adding a task
+ * means defining its type above and listing it here.
+ */
+using Tasks = TaskSet<tasks::EQU, tasks::XOR, tasks::NOR, tasks::ANDN, tasks::OR, tasks::ORN,
+                      tasks::AND, tasks::NAND, tasks::NOT>;
+
+/** A task's position in Tasks. */
+using TaskId = size_t;
+
+constexpr size_t NUM_TASKS = Tasks::SIZE;
+
+/** The task that pays its reward in the reward-none condition. */
+constexpr TaskId TASK_EQU = Tasks::IndexOf<tasks::EQU>();
+
+/** Human-readable task names, indexed by TaskId. */
+constexpr const std::array<const char *, NUM_TASKS> &TASK_NAMES = Tasks::NAMES;
+
+/** Points for performing each task, indexed by TaskId. */
+constexpr const std::array<double, NUM_TASKS> &TASK_REWARDS = Tasks::REWARDS;
+
+/** How many inputs each task's logic function takes, indexed by TaskId. */
+constexpr const std::array<uint8_t, NUM_TASKS> &TASK_ARITY = Tasks::ARITY;
+
+/** Points each task gives when the output does not perform it. */
+constexpr double TASK_FAIL_POINTS = 1.0;
+
+/**
+ * Points earned for an output, for every possible bitmask of performed tasks.
+ * `all` is the reward-all condition, where every task pays its reward;
+ * `equ_only` is the reward-none condition, where only EQU pays its reward and
+ * every other task pays the failure points whether it was performed or not.
+ */
+struct TaskPointTable {
+  double all[1 << NUM_TASKS];
+  double equ_only[1 << NUM_TASKS];
 };
 
-class NOR : public Task {
-
-    public:
-        /**
-         * @brief Evaluates the given output against the expected result based on the task's criterion.
-         *
-         * This function processes an organism's output by comparing it against values derived from the input array.
-         * A set larger value of points is rewarded if an organism succeeds in carrying out the logic task. This value is 
-         * proportional to the difficulty of carrying out that task. If the organism fails the task, it gets 1 point to
-         * allow it to still work towards reproducing.
-         *
-         * @param output The output value produced by an organism.
-         * @param inputs An array of input values used for evaluation.
-         * @return double The score awarded based on how closely the output matches the expected value.
-         */
-        double CheckOutput(uint32_t output, uint32_t inputs[4]) override {
-            // did they calculate NOT of a number?
-            for (int i = 0; i < 3; i++) {
-                int plusOne = i + 1;
-                uint32_t val = inputs[i]; //~ is bitwise NOT in C++
-                uint32_t val_2 = inputs[plusOne];
-                uint32_t nor_val = ~(val | val_2);
-                if (nor_val == output) {
-                    // 10 points for success
-                    return 160.0;
-                }
-            // 0 points for failure
-            }
-            return 1.0;
-        }
-
-        /**
-         * @brief Returns the name of the task.
-         *
-         * This function provides a string identifier for the task, which can be used for logging, debugging, 
-         * or display purposes.
-         *
-         * @return std::string The name of the task.
-         */
-        std::string name() const override { return "NOR"; }
+constexpr TaskPointTable MakeTaskPointTable() {
+  TaskPointTable table{};
+  for (uint32_t mask = 0; mask < (1u << NUM_TASKS); mask++) {
+    double all = 0.0;
+    double equ_only = 0.0;
+    for (size_t task = 0; task < NUM_TASKS; task++) {
+      double task_points = (mask >> task) & 1 ? TASK_REWARDS[task] : TASK_FAIL_POINTS;
+      all += task_points;
+      equ_only += task == TASK_EQU ? task_points : TASK_FAIL_POINTS;
+    }
+    table.all[mask] = all;
+    table.equ_only[mask] = equ_only;
+  }
+  return table;
+}
+
+constexpr TaskPointTable TASK_POINTS = MakeTaskPointTable();
+
+/**
+ * Given the output value the organism produced and the last INPUT_WINDOW inputs
+ * it received, returns a bitmask with bit TaskId set for every task the output
+ * performs. The simulation looks outputs up in candidates precomputed from
+ * TASK_CHECKS instead; this is the direct evaluation they must agree with.
+ */
+inline uint32_t EvaluateTasks(uint32_t output, const uint32_t inputs[INPUT_WINDOW]) {
+  return Tasks::Evaluate(output, inputs);
+}
+
+/**
+ * Input: A task and up to three inputs, in the order the task takes them
+ *
+ * Output: The output that performs the task on those inputs
+ *
+ * Purpose: Looks up a task's logic function by TaskId.
+ */
+constexpr uint32_t TaskOutput(size_t task, uint32_t a, uint32_t b, uint32_t c) {
+  return Tasks::Output(task, a, b, c);
+}
+
+/**
+ * One way an output can perform a task: the task's logic function applied to
+ * the inputs in the given slots of the input window. Slots are positions in
+ * the window's ring buffer, not ages.
+ */
+struct TaskCheck {
+  uint8_t task;
+  uint8_t arity;
+  uint8_t slots[3];
 };
 
-class XOR : public Task {
-
-    public:
-        /**
-         * @brief Evaluates the given output against the expected result based on the task's criterion.
-         *
-         * This function processes an organism's output by comparing it against values derived from the input array.
-         * A set larger value of points is rewarded if an organism succeeds in carrying out the logic task. This value is 
-         * proportional to the difficulty of carrying out that task. If the organism fails the task, it gets 1 point to
-         * allow it to still work towards reproducing.
-         *
-         * @param output The output value produced by an organism.
-         * @param inputs An array of input values used for evaluation.
-         * @return double The score awarded based on how closely the output matches the expected value.
-         */
-        double CheckOutput(uint32_t output, uint32_t inputs[4]) override {
-            // did they calculate NOT of a number?
-            for (int i = 0; i < 3; i++) {
-                int plusOne = i + 1;
-                uint32_t val = inputs[i]; //~ is bitwise NOT in C++
-                uint32_t val_2 = inputs[plusOne];
-                uint32_t xor_val = val ^ val_2;
-                if (xor_val == output) {
-                    // 10 points for success
-                    return 161.0;
-                }
-            // 0 points for failure
-            }
-            return 1.0;
-        }
-
-        /**
-         * @brief Returns the name of the task.
-         *
-         * This function provides a string identifier for the task, which can be used for logging, debugging, 
-         * or display purposes.
-         *
-         * @return std::string The name of the task.
-         */
-        std::string name() const override { return "XOR"; }
+/**
+ * Input: None
+ *
+ * Output: The number of checks for the given window and task arities
+ *
+ * Purpose: Sizes TASK_CHECKS. A task taking n inputs is checked on every run
+ * of n adjacent slots.
+ */
+constexpr size_t CountTaskChecks() {
+  size_t count = 0;
+  for (size_t task = 0; task < NUM_TASKS; task++) {
+    count += INPUT_WINDOW + 1 - TASK_ARITY[task];
+  }
+  return count;
+}
+
+constexpr size_t NUM_TASK_CHECKS = CountTaskChecks();
+
+constexpr std::array<TaskCheck, NUM_TASK_CHECKS> MakeTaskChecks() {
+  std::array<TaskCheck, NUM_TASK_CHECKS> checks{};
+  size_t check = 0;
+  for (size_t task = 0; task < NUM_TASKS; task++) {
+    for (size_t first = 0; first + TASK_ARITY[task] <= INPUT_WINDOW; first++) {
+      checks[check].task = task;
+      checks[check].arity = TASK_ARITY[task];
+      for (size_t i = 0; i < 3; i++) {
+        checks[check].slots[i] = i < TASK_ARITY[task] ? first + i : first;
+      }
+      check++;
+    }
+  }
+  return checks;
+}
+
+/** Every check the task engine makes for each output. */
+constexpr std::array<TaskCheck, NUM_TASK_CHECKS> TASK_CHECKS = MakeTaskChecks();
+
+/**
+ * Input: A check and the input window
+ *
+ * Output: The output that passes the check with these inputs
+ *
+ * Purpose: Computes one precomputed candidate output.
+ */
+constexpr uint32_t CheckCandidate(const TaskCheck &check, const uint32_t *inputs) {
+  return TaskOutput(check.task, inputs[check.slots[0]], inputs[check.slots[1]],
+                    inputs[check.slots[2]]);
+}
+
+/**
+ * The checks that read each window slot, so that a new input only recomputes
+ * the candidates that depend on it.
+ */
+struct SlotCheckTable {
+  size_t count[INPUT_WINDOW];
+  uint8_t checks[INPUT_WINDOW][NUM_TASK_CHECKS];
 };
 
-class EQU : public Task {
-
-    public:
-        /**
-         * @brief Evaluates the given output against the expected result based on the task's criterion.
-         *
-         * This function processes an organism's output by comparing it against values derived from the input array.
-         * A set larger value of points is rewarded if an organism succeeds in carrying out the logic task. This value is 
-         * proportional to the difficulty of carrying out that task. If the organism fails the task, it gets 1 point to
-         * allow it to still work towards reproducing.
-         *
-         * @param output The output value produced by an organism.
-         * @param inputs An array of input values used for evaluation.
-         * @return double The score awarded based on how closely the output matches the expected value.
-         */
-        double CheckOutput(uint32_t output, uint32_t inputs[4]) override {
-            // did they calculate NOT of a number?
-            for (int i = 0; i < 3; i++) {
-                int plusOne = i + 1;
-                uint32_t val = inputs[i]; //~ is bitwise NOT in C++
-                uint32_t val_2 = inputs[plusOne];
-                uint32_t equ_val = ~(val ^ val_2);
-                if (equ_val == output) {
-                    // 10 points for success
-                    return 320.0;
-                }
-            // 0 points for failure
-            }
-            return 1.0;
-        }
-
-        /**
-         * @brief Returns the name of the task.
-         *
-         * This function provides a string identifier for the task, which can be used for logging, debugging, 
-         * or display purposes.
-         *
-         * @return std::string The name of the task.
-         */
-        std::string name() const override { return "EQU"; }
+constexpr SlotCheckTable MakeSlotCheckTable() {
+  SlotCheckTable table{};
+  for (size_t check = 0; check < NUM_TASK_CHECKS; check++) {
+    for (size_t slot = 0; slot < INPUT_WINDOW; slot++) {
+      bool reads_slot = false;
+      for (size_t i = 0; i < TASK_CHECKS[check].arity; i++) {
+        reads_slot = reads_slot || TASK_CHECKS[check].slots[i] == slot;
+      }
+      if (reads_slot) {
+        table.checks[slot][table.count[slot]++] = check;
+      }
+    }
+  }
+  return table;
+}
+
+constexpr SlotCheckTable SLOT_CHECKS = MakeSlotCheckTable();
+
+/** The task bit each check sets when it passes, indexed like TASK_CHECKS. */
+struct CheckTaskBits {
+  uint32_t bits[NUM_TASK_CHECKS];
 };
 
-#endif
\ No newline at end of file
+constexpr CheckTaskBits MakeCheckTaskBits() {
+  CheckTaskBits table{};
+  for (size_t check = 0; check < NUM_TASK_CHECKS; check++) {
+    table.bits[check] = uint32_t{1} << TASK_CHECKS[check].task;
+  }
+  return table;
+}
+
+constexpr CheckTaskBits CHECK_TASK_BITS = MakeCheckTaskBits();
+
+/** CheckCandidate() for a check known at compile time, calling its task's function directly. */
+template <size_t CHECK>
+constexpr uint32_t CheckCandidate(const uint32_t *inputs) {
+  constexpr TaskCheck check = TASK_CHECKS[CHECK];
+  return Tasks::Type<check.task>::Output(inputs[check.slots[0]], inputs[check.slots[1]],
+                                         inputs[check.slots[2]]);
+}
+
+template <size_t SLOT, size_t... I>
+inline void UpdateSlotCandidates(uint32_t *candidates, const uint32_t *inputs,
+                                 std::index_sequence<I...>) {
+  ((candidates[SLOT_CHECKS.checks[SLOT][I]] = CheckCandidate<SLOT_CHECKS.checks[SLOT][I]>(inputs)),
+   ...);
+}
+
+template <size_t... SLOTS>
+inline void UpdateCandidates(size_t slot, uint32_t *candidates, const uint32_t *inputs,
+                             std::index_sequence<SLOTS...>) {
+  ((slot == SLOTS ? UpdateSlotCandidates<SLOTS>(candidates, inputs,
+                                                std::make_index_sequence<SLOT_CHECKS.count[SLOTS]>{})
+                  : void()),
+   ...);
+}
+
+/**
+ * Input: The candidates of an input window, the window, and the slot that
+ * just changed
+ *
+ * Output: None
+ *
+ * Purpose: Recomputes only the candidates that read the changed slot. The
+ * checks are expanded at compile time for each slot, so every candidate is
+ * computed by straight-line code with its task's function inlined.
+ */
+inline void UpdateCandidates(size_t slot, uint32_t *candidates, const uint32_t *inputs) {
+  UpdateCandidates(slot, candidates, inputs, std::make_index_sequence<INPUT_WINDOW>{});
+}
+
+/**
+ * Input: The candidates of an input window and an output
+ *
+ * Output: A bitmask with bit TaskId set for every task the output performs,
+ * the same as EvaluateTasks() on the window
+ *
+ * Purpose: Scores an output with one branch-free pass of compares over the
+ * precomputed candidates, which compilers vectorize.
+ */
+inline uint32_t MatchCandidates(const uint32_t *candidates, uint32_t output) {
+  uint32_t done = 0;
+  for (size_t check = 0; check < NUM_TASK_CHECKS; check++) {
+    done |= candidates[check] == output ? CHECK_TASK_BITS.bits[check] : 0;
+  }
+  return done;
+}
+
+#endif
@@ -0,0 +1,112 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * A fixed set of worker threads that repeatedly run the same kind of job. The
+ * workers are created once and parked between jobs, so handing a job to the
+ * pool every update costs a wake-up rather than a thread creation.
+ */
+class ThreadPool {
+  std::vector<std::thread> workers;
+  std::mutex mutex;
+  std::condition_variable start_cv;
+  std::condition_variable done_cv;
+  const std::function<void(size_t)> *job = nullptr;
+  size_t generation = 0;
+  size_t pending = 0;
+  bool stopping = false;
+
+  /**
+   * Input: The index of this worker thread
+   *
+   * Output: None
+   *
+   * Purpose: Waits for each new job, runs it, and reports completion.
+   */
+  void WorkerLoop(size_t thread_id) {
+    size_t seen_generation = 0;
+    while (true) {
+      const std::function<void(size_t)> *current_job;
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        start_cv.wait(lock, [&] { return stopping || generation != seen_generation; });
+        if (stopping) {
+          return;
+        }
+        seen_generation = generation;
+        current_job = job;
+      }
+      (*current_job)(thread_id);
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--pending == 0) {
+          done_cv.notify_one();
+        }
+      }
+    }
+  }
+
+public:
+  /**
+   * Creates a pool that runs jobs on num_threads threads in total, including
+   * the thread that calls Run().
+   */
+  explicit ThreadPool(size_t num_threads) {
+    for (size_t i = 1; i < num_threads; i++) {
+      workers.emplace_back([this, i] { WorkerLoop(i); });
+    }
+  }
+
+  ~ThreadPool() {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      stopping = true;
+    }
+    start_cv.notify_all();
+    for (std::thread &worker : workers) {
+      worker.join();
+    }
+  }
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  /**
+   * Input: None
+   *
+   * Output: The number of threads a job runs on, including the caller
+   *
+   * Purpose: Lets callers size per-thread buffers.
+   */
+  size_t GetNumThreads() const { return workers.size() + 1; }
+
+  /**
+   * Input: A function taking the index of the thread running it
+   *
+   * Output: None
+   *
+   * Purpose: Runs the function once on every thread (the calling thread is
+   * index 0) and returns when all of them have finished.
+   */
+  void Run(const std::function<void(size_t)> &fun) {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      job = &fun;
+      pending = workers.size();
+      generation++;
+    }
+    start_cv.notify_all();
+    fun(0);
+    std::unique_lock<std::mutex> lock(mutex);
+    done_cv.wait(lock, [this] { return pending == 0; });
+  }
+};
+
+#endif
@@ -1,39 +1,159 @@
 #ifndef WORLD_H
 #define WORLD_H
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
 #include "emp/Evolve/World.hpp"
 #include "emp/data/DataFile.hpp"
 
+#include "AsyncCensusWriter.h"
+#include "CensusFile.h"
+#include "Checkpoint.h"
+#include "CounterRandom.h"
 #include "Org.h"
+#include "OrgWorldBase.h"
+#include "Phylogeny.h"
+#include "ReplayLog.h"
+#include "Stats.h"
 #include "Task.h"
+#include "ThreadPool.h"
+
+// How many schedule entries a thread claims at a time in parallel CallProcess
+constexpr size_t PROCESS_CHUNK = 64;
+
+/**
+ * What CPU time is shared out by. With MERIT_NONE every organism runs the same number
+ * of cycles each update; otherwise the update's cycles are shared out in proportion to the
+ * points its completed tasks are worth (MERIT_TASKS) or to its current points
+ * (MERIT_POINTS).
+ */
+enum MeritType { MERIT_NONE, MERIT_TASKS, MERIT_POINTS, NUM_MERIT_TYPES };
+
+/**
+ * Which cells of a grid an offspring can be placed in: the eight cells surrounding its
+ * parent (NEIGHBORHOOD_MOORE) or the four orthogonally adjacent ones
+ * (NEIGHBORHOOD_VON_NEUMANN). The grid wraps around at its edges.
+ */
+enum Neighborhood { NEIGHBORHOOD_MOORE, NEIGHBORHOOD_VON_NEUMANN, NUM_NEIGHBORHOODS };
+
+/**
+ * The world of organisms running the instruction set described by Spec (NandSpec or
+ * NandXorSpec).
+ */
+// OrgWorldBase comes first so the state store outlives emp::World, whose destructor
+// removes every organism and so triggers the death callback that clears the store
+template <typename Spec>
+class OrgWorld : public OrgWorldBase, public emp::World<Organism<Spec>> {
+  using base_t = emp::World<Organism<Spec>>;
+  using typename base_t::pop_t;
+  using base_t::pop;
+  using base_t::update;
+  using base_t::fun_find_birth_pos;
 
-class OrgWorld : public emp::World<Organism> {
   emp::vector<emp::WorldPosition> reproduce_queue;
-  std::vector<Task*> tasks{new EQU(), new XOR(), new NOR(), new ANDN(), new OR(), new ORN(), new AND(), new NAND(), new NOT()};
-  emp::Ptr<emp::DataMonitor<int>> EQUCount;
-  emp::Ptr<emp::DataMonitor<int>> XORCount;
-  emp::Ptr<emp::DataMonitor<int>> NORCount;
-  emp::Ptr<emp::DataMonitor<int>> ANDNCount;
-  emp::Ptr<emp::DataMonitor<int>> ORCount;
-  emp::Ptr<emp::DataMonitor<int>> ORNCount;
-  emp::Ptr<emp::DataMonitor<int>> ANDCount;
-  emp::Ptr<emp::DataMonitor<int>> NANDCount;
-  emp::Ptr<emp::DataMonitor<int>> NOTCount;
-  bool reward;
+  emp::Ptr<ThreadPool> thread_pool;
+  uint64_t seed = 0;
+  // One data monitor per task, fed by the census; null until requested
+  std::array<emp::Ptr<emp::DataMonitor<int>>, NUM_TASKS> task_count_nodes{};
+  // Number of living organisms that have performed each task, by TaskId
+  std::array<int, NUM_TASKS> task_counts{};
+  bool census_registered = false;
+  // Census rows output, null unless set up; its writer callback is registered once
+  // and writes to whichever file is current
+  emp::Ptr<CensusOutput> census_file;
+  bool census_file_registered = false;
+  // Census rows are written on updates that are multiples of this
+  size_t census_file_interval = 1;
+  // Task count file written through emp::DataFile, null unless set up; written from
+  // an update callback of its own so its writes can be timed
+  emp::Ptr<emp::DataFile> data_file;
+  bool data_file_registered = false;
+  // Average CPU cycles per organism per update, and how they are shared out
+  uint32_t cycles_per_org = 10;
+  MeritType merit_type = MERIT_NONE;
+  // Cycles each cell runs this update under merit scheduling
+  emp::vector<uint32_t> cycle_budgets;
+  std::vector<double> merits;
+  // Every distinct genome in the population, shared by the organisms carrying it
+  GenomeStore<Spec> genomes;
+  // Lineage tracking, null unless enabled, and the taxon of the organism in each cell
+  emp::Ptr<Phylogeny> phylogeny;
+  emp::vector<uint32_t> cell_taxa;
+  // Birth neighborhood of a grid world: the neighbors of cell i are the entries
+  // [i * neighbors_per_cell, (i + 1) * neighbors_per_cell) of neighbor_table
+  Neighborhood neighborhood = NEIGHBORHOOD_MOORE;
+  size_t neighbors_per_cell = 0;
+  emp::vector<uint32_t> neighbor_table;
+  // Update loop instrumentation, null unless enabled: statistics since the last log
+  // line, the run's totals, and the log written every stats_interval updates
+  emp::Ptr<UpdateStats> stats;
+  UpdateStats total_stats;
+  std::ofstream stats_log;
+  size_t stats_interval = 0;
+  std::mutex stats_mutex;
+  // Per-update hashes for comparing runs, null unless enabled; the record is reused
+  emp::Ptr<ReplayLogWriter> replay_log;
+  ReplayRecord replay_record;
+
+  // Size of the instruction set; checkpointed genomes are only valid for the same set
+  static constexpr uint32_t NUM_OPS = Spec::library_t::GetSize();
 
 public:
-  OrgWorld(emp::Random &_random) : emp::World<Organism>(_random) {}
+  using base_t::AddOrgAt;
+  using base_t::GetHeight;
+  using base_t::GetRandom;
+  using base_t::GetSize;
+  using base_t::GetWidth;
+  using base_t::IsOccupied;
+  using base_t::OnUpdate;
+  using base_t::SetupFile;
+
+  OrgWorld(emp::Random &_random) : base_t(_random) {
+    // Organisms are only ever added to empty cells (BirthInPlace reuses occupied ones),
+    // so clearing on death never touches a living organism's state
+    this->OnOrgDeath([this](size_t pos) {
+      if (phylogeny) {
+        phylogeny->RemoveOrg(cell_taxa[pos], states.tasks_done[pos]);
+        cell_taxa[pos] = Phylogeny::NONE;
+      }
+      states.Clear(pos);
+    });
+    // Organisms placed without a parent (ancestors, checkpoint loads) start new lineages;
+    // BirthInPlace assigns offspring their taxon before placing them
+    this->OnPlacement([this](size_t pos) {
+      if (phylogeny) {
+        if (cell_taxa[pos] == Phylogeny::NONE) {
+          cell_taxa[pos] = phylogeny->AddRoot(update);
+        }
+        phylogeny->AddOrg(cell_taxa[pos]);
+      }
+    });
+  }
 
   ~OrgWorld() {
-    if (EQUCount) {EQUCount.Delete();}
-    if (XORCount) {XORCount.Delete();}
-    if (NORCount) {NORCount.Delete();}
-    if (ANDNCount) {ANDNCount.Delete();}
-    if (ORCount) {ORCount.Delete();}
-    if (ORNCount) {ORNCount.Delete();}
-    if (ANDCount) {ANDCount.Delete();}
-    if (NANDCount) {NANDCount.Delete();}
-    if (NOTCount) {NOTCount.Delete();}
+    // Organisms hold handles into the genome store, which is destroyed before emp::World
+    base_t::Clear();
+    for (emp::Ptr<emp::DataMonitor<int>> node : task_count_nodes) {
+      if (node) { node.Delete(); }
+    }
+    if (thread_pool) { thread_pool.Delete(); }
+    if (census_file) { census_file.Delete(); }
+    if (data_file) { data_file.Delete(); }
+    if (phylogeny) { phylogeny.Delete(); }
+    if (stats) { stats.Delete(); }
+    if (replay_log) { replay_log.Delete(); }
+    if (resources) { resources.Delete(); }
   }
 
   /**
@@ -45,224 +165,526 @@ public:
    */
   const pop_t &GetPopulation() { return pop; }
 
-  void SetReward(bool rewardBool) { reward = rewardBool; }
+  /**
+   * @brief Returns the store of the distinct genomes in the population.
+   *
+   * @return GenomeStore<Spec>& The store organisms' genome handles point into.
+   */
+  GenomeStore<Spec> &GetGenomes() { return genomes; }
+  const GenomeStore<Spec> &GetGenomes() const { return genomes; }
+
+  /**
+   * @brief Resizes the world as a grid, along with the task state store, any resources
+   * and, once SetPopStruct_Grid has set up birth neighborhoods, the neighbor table.
+   *
+   * @param width The number of cells in each row.
+   * @param height The number of rows.
+   */
+  void Resize(size_t width, size_t height) {
+    base_t::Resize(width, height);
+    states.Resize(GetSize());
+    cell_taxa.resize(GetSize(), Phylogeny::NONE);
+    if (neighbors_per_cell) {
+      BuildNeighborTable();
+    }
+    if (resources) {
+      resources->Resize(width, height);
+    }
+  }
 
-  bool GetReward() { return reward; }
+  /**
+   * @brief Fills the neighbor table for the current grid dimensions and neighborhood.
+   */
+  void BuildNeighborTable() {
+    static constexpr int MOORE[8][2] = {{-1, -1}, {0, -1}, {1, -1}, {-1, 0},
+                                        {1, 0},   {-1, 1}, {0, 1},  {1, 1}};
+    static constexpr int VON_NEUMANN[4][2] = {{0, -1}, {-1, 0}, {1, 0}, {0, 1}};
+    const int (*offsets)[2] = neighborhood == NEIGHBORHOOD_MOORE ? MOORE : VON_NEUMANN;
+    neighbors_per_cell = neighborhood == NEIGHBORHOOD_MOORE ? 8 : 4;
+    const int width = GetWidth(), height = GetHeight();
+    neighbor_table.resize(GetSize() * neighbors_per_cell);
+    for (int y = 0; y < height; y++) {
+      for (int x = 0; x < width; x++) {
+        uint32_t *neighbors = &neighbor_table[(y * width + x) * neighbors_per_cell];
+        for (size_t n = 0; n < neighbors_per_cell; n++) {
+          const int nx = (x + offsets[n][0] + width) % width;
+          const int ny = (y + offsets[n][1] + height) % height;
+          neighbors[n] = ny * width + nx;
+        }
+      }
+    }
+  }
 
   /**
-   * @brief Retrieves the data monitor tracking the count of organisms with the 'EQU' state.
+   * @brief Makes the world a toroidal grid where offspring are placed next to their parent.
    *
-   * This function ensures that the data monitor for counting organisms whose state indicates 
-   * they have performed "EQU" is properly instantiated and updated. On the first call, it initializes the 
-   * monitor and registers an update callback that iterates over the population to count relevant organisms.
+   * Sets up Empirical's grid structure, then replaces its birth placement with a draw from
+   * a table of each cell's neighbors, built once here and on every later grid resize, so
+   * placing an offspring is a single random draw and lookup. Offspring therefore land
+   * within one row of their parent, and so do their entries in the state store.
    *
-   * @return emp::DataMonitor<int>& Reference to the data monitor tracking EQU counts.
+   * @param width The number of cells in each row.
+   * @param height The number of rows.
+   * @param _neighborhood Which surrounding cells offspring can be placed in.
    */
-  emp::DataMonitor<int> & GetEQUCountDataNode() {
-      if (!EQUCount) {
-        EQUCount.New();
-        OnUpdate([this](size_t){
-          EQUCount->Reset();
-          for (size_t i = 0; i < pop.size(); i++) {
-            if (IsOccupied(i)) {
-              if (pop[i]->getCPU().state.doneEQU) { EQUCount->AddDatum(1); }
-            }
-          }
-        });
-      }
-      return *EQUCount;
+  void SetPopStruct_Grid(size_t width, size_t height,
+                         Neighborhood _neighborhood = NEIGHBORHOOD_MOORE) {
+    base_t::SetPopStruct_Grid(width, height);
+    neighborhood = _neighborhood;
+    Resize(width, height);
+    BuildNeighborTable();
+    fun_find_birth_pos = [this](emp::Ptr<Organism<Spec>>, emp::WorldPosition parent_pos) {
+      const size_t neighbor = GetRandom().GetUInt(neighbors_per_cell);
+      return emp::WorldPosition(
+          neighbor_table[parent_pos.GetIndex() * neighbors_per_cell + neighbor]);
+    };
   }
 
   /**
-   * @brief Retrieves the data monitor tracking the count of organisms with the 'XOR' state.
+   * @brief Resizes the world to a number of cells, along with the task state store. Any
+   * resources are laid out as a single row.
    *
-   * This function ensures that the data monitor for counting organisms whose state indicates 
-   * they have performed "XOR" is properly instantiated and updated. On the first call, it initializes the 
-   * monitor and registers an update callback that iterates over the population to count relevant organisms.
+   * @param new_size The number of cells.
+   */
+  void Resize(size_t new_size) {
+    base_t::Resize(new_size);
+    states.Resize(GetSize());
+    cell_taxa.resize(GetSize(), Phylogeny::NONE);
+    if (resources) {
+      resources->Resize(new_size, 1);
+    }
+  }
+
+  /**
+   * @brief Estimates the memory used by each organism.
+   *
+   * Counts the Organism object itself (CPU cores and state handle), its share of the
+   * deduplicated genome store, and the per-cell bookkeeping the world keeps for it,
+   * including its task state arrays. Genome storage is split over the current population,
+   * so this should be called once organisms have been added.
    *
-   * @return emp::DataMonitor<int>& Reference to the data monitor tracking XOR counts.
+   * @return size_t Approximate bytes per organism.
    */
-  emp::DataMonitor<int> & GetXORCountDataNode() {
-      if (!XORCount) {
-        XORCount.New();
-        OnUpdate([this](size_t){
-          XORCount->Reset();
-          for (size_t i = 0; i < pop.size(); i++) {
-            if (IsOccupied(i)) {
-              if (pop[i]->getCPU().state.doneXOR) { XORCount->AddDatum(1); }
-            }
-          }
-        });
-      }
-      return *XORCount;
+  size_t GetBytesPerOrg() const {
+    size_t num_orgs = 0;
+    for (size_t i = 0; i < pop.size(); i++) {
+      num_orgs += IsOccupied(i);
+    }
+    const size_t genome_bytes =
+        genomes.GetNumInstructions() * sizeof(sgpl::Instruction<Spec>) +
+        genomes.GetNumGenomes() * sizeof(typename GenomeStore<Spec>::Genome);
+    const size_t per_cell_bytes =
+        sizeof(emp::Ptr<Organism<Spec>>) + sizeof(uint8_t) + OrgStateStore::BYTES_PER_CELL;
+    return sizeof(Organism<Spec>) + (num_orgs ? genome_bytes / num_orgs : 0) + per_cell_bytes;
   }
 
   /**
-   * @brief Retrieves the data monitor tracking the count of organisms with the 'NOR' state.
+   * @brief Sets the seed that organisms' input streams are derived from.
    *
-   * This function ensures that the data monitor for counting organisms whose state indicates 
-   * they have performed "NOR" is properly instantiated and updated. On the first call, it initializes the 
-   * monitor and registers an update callback that iterates over the population to count relevant organisms.
+   * @param _seed The run's random seed.
+   */
+  void SetSeed(uint64_t _seed) { seed = _seed; }
+
+  /**
+   * @brief Sets how many threads CallProcess spreads organisms over.
    *
-   * @return emp::DataMonitor<int>& Reference to the data monitor tracking NOR counts.
+   * Results do not depend on the number of threads: every cell draws its inputs
+   * from its own stream keyed on (seed, update, cell), and reproduction requests
+   * are collected in schedule order afterwards.
+   *
+   * @param num_threads The total number of threads to use; 1 runs serially.
    */
-  emp::DataMonitor<int> & GetNORCountDataNode() {
-      if (!NORCount) {
-        NORCount.New();
-        OnUpdate([this](size_t){
-          NORCount->Reset();
-          for (size_t i = 0; i < pop.size(); i++) {
-            if (IsOccupied(i)) {
-              if (pop[i]->getCPU().state.doneNOR) { NORCount->AddDatum(1); }
-            }
-          }
-        });
+  void SetThreads(size_t num_threads) {
+    if (thread_pool) { thread_pool.Delete(); }
+    if (num_threads > 1) { thread_pool.New(num_threads); }
+  }
+
+  /**
+   * @brief Makes task rewards depend on depletable per-task resources; see ResourceGrid.h.
+   *
+   * Every cell starts at the resources' equilibrium level. The grid follows the world's
+   * size from then on, and the levels are saved in checkpoints.
+   *
+   * @param settings How the resources flow.
+   */
+  void EnableResources(const ResourceSettings & settings) {
+    if (resources) { resources.Delete(); }
+    resources = emp::NewPtr<ResourceGrid>(settings);
+    if (GetHeight() > 0 && GetWidth() * GetHeight() == GetSize()) {
+      resources->Resize(GetWidth(), GetHeight());
+    } else {
+      resources->Resize(GetSize(), 1);
+    }
+  }
+
+  /**
+   * @brief Turns on lineage tracking.
+   *
+   * Organisms already in the world each start a lineage of their own, as do organisms placed
+   * later without a parent. From then on every birth either joins its parent's taxon or, if
+   * mutation changed its genome, founds a child taxon; see Phylogeny.h. Tracking is not
+   * checkpointed, so a resumed run starts new lineages at the checkpoint.
+   */
+  void EnablePhylogeny() {
+    if (phylogeny) {
+      return;
+    }
+    phylogeny.New();
+    cell_taxa.assign(GetSize(), Phylogeny::NONE);
+    for (size_t i = 0; i < pop.size(); i++) {
+      if (IsOccupied(i)) {
+        cell_taxa[i] = phylogeny->AddRoot(update);
+        phylogeny->AddOrg(cell_taxa[i]);
       }
-      return *NORCount;
+    }
   }
 
   /**
-   * @brief Retrieves the data monitor tracking the count of organisms with the 'ANDN' state.
+   * @brief Returns the lineage tracker, or null if tracking is off.
+   *
+   * @return emp::Ptr<Phylogeny> The phylogeny of the population.
+   */
+  emp::Ptr<Phylogeny> GetPhylogeny() { return phylogeny; }
+
+  /**
+   * @brief Writes the current phylogeny to a file.
    *
-   * This function ensures that the data monitor for counting organisms whose state indicates 
-   * they have performed "ANDN" is properly instantiated and updated. On the first call, it initializes the 
-   * monitor and registers an update callback that iterates over the population to count relevant organisms.
+   * The tasks of living organisms are merged into their taxa first, so the snapshot is
+   * up to date.
    *
-   * @return emp::DataMonitor<int>& Reference to the data monitor tracking ANDN counts.
+   * @param filename The path of the comma-separated file to write.
    */
-  emp::DataMonitor<int> & GetANDNCountDataNode() {
-      if (!ANDNCount) {
-        ANDNCount.New();
-        OnUpdate([this](size_t){
-          ANDNCount->Reset();
-          for (size_t i = 0; i < pop.size(); i++) {
-            if (IsOccupied(i)) {
-              if (pop[i]->getCPU().state.doneANDN) { ANDNCount->AddDatum(1); }
-            }
-          }
-        });
+  void SavePhylogeny(const std::string & filename) {
+    if (!phylogeny) {
+      return;
+    }
+    for (size_t i = 0; i < pop.size(); i++) {
+      if (IsOccupied(i)) {
+        phylogeny->RecordTasks(cell_taxa[i], states.tasks_done[i]);
       }
-      return *ANDNCount;
+    }
+    phylogeny->WriteSnapshot(filename);
   }
 
+  using genome_t = typename GenomeStore<Spec>::Genome;
+
   /**
-   * @brief Retrieves the data monitor tracking the count of organisms with the 'OR' state.
+   * @brief Finds the genomes carried by the most organisms.
    *
-   * This function ensures that the data monitor for counting organisms whose state indicates 
-   * they have performed "OR" is properly instantiated and updated. On the first call, it initializes the 
-   * monitor and registers an update callback that iterates over the population to count relevant organisms.
+   * Every organism holds one reference to its genome, so a genome's reference count is the
+   * number of organisms carrying it. The population is scanned in cell order with a bounded
+   * heap, which touches the genomes in roughly the order they were allocated; walking the
+   * genome store instead visits them in hash order and is several times slower on large
+   * worlds with many distinct genomes.
    *
-   * @return emp::DataMonitor<int>& Reference to the data monitor tracking OR counts.
+   * @param k How many genomes to return.
+   * @return The genomes with their abundances, most abundant first; ties are broken by hash
+   * so reports are reproducible.
    */
-  emp::DataMonitor<int> & GetORCountDataNode() {
-      if (!ORCount) {
-        ORCount.New();
-        OnUpdate([this](size_t){
-          ORCount->Reset();
-          for (size_t i = 0; i < pop.size(); i++) {
-            if (IsOccupied(i)) {
-              if (pop[i]->getCPU().state.doneOR) { ORCount->AddDatum(1); }
-            }
-          }
-        });
+  std::vector<std::pair<const genome_t *, size_t>> GetMostAbundantGenomes(size_t k) const {
+    struct Candidate {
+      size_t organisms;
+      uint64_t hash;
+      const genome_t *genome;
+      bool operator<(const Candidate & other) const {
+        return organisms != other.organisms ? organisms > other.organisms : hash < other.hash;
       }
-      return *ORCount;
+    };
+    // A min-heap of the k most abundant genomes seen so far, and which genomes it holds
+    std::vector<Candidate> heap;
+    std::unordered_set<const genome_t *> in_heap;
+    for (size_t i = 0; k && i < pop.size(); i++) {
+      if (!IsOccupied(i)) {
+        continue;
+      }
+      const genome_t & genome = pop[i]->getCPU().GetGenome();
+      const Candidate candidate{genome.refs, genome.hash, &genome};
+      if (heap.size() == k && !(candidate < heap.front())) {
+        continue;
+      }
+      if (!in_heap.insert(&genome).second) {
+        continue;
+      }
+      if (heap.size() == k) {
+        std::pop_heap(heap.begin(), heap.end());
+        in_heap.erase(heap.back().genome);
+        heap.pop_back();
+      }
+      heap.push_back(candidate);
+      std::push_heap(heap.begin(), heap.end());
+    }
+    std::sort_heap(heap.begin(), heap.end());
+    std::vector<std::pair<const genome_t *, size_t>> abundant;
+    abundant.reserve(heap.size());
+    for (const Candidate & candidate : heap) {
+      abundant.emplace_back(candidate.genome, candidate.organisms);
+    }
+    return abundant;
   }
 
   /**
-   * @brief Retrieves the data monitor tracking the count of organisms with the 'ORN' state.
+   * @brief Runs a genome in isolation on test inputs and writes its execution trace.
    *
-   * This function ensures that the data monitor for counting organisms whose state indicates 
-   * they have performed "ORN" is properly instantiated and updated. On the first call, it initializes the 
-   * monitor and registers an update callback that iterates over the population to count relevant organisms.
+   * The genome runs in a single-cell sandbox with the world's reward condition, starting
+   * from zero points, in steps of the world's cycles per organism; see CPU::Trace. The test
+   * inputs depend only on the seed, so traces of different genotypes, or from different
+   * runs, are comparable. The world itself is not touched.
    *
-   * @return emp::DataMonitor<int>& Reference to the data monitor tracking ORN counts.
+   * @param program The genome to run.
+   * @param n_cycles How many CPU cycles to trace.
+   * @param out The stream to write the trace to.
+   * @param input_seed The seed of the test inputs.
    */
-  emp::DataMonitor<int> & GetORNCountDataNode() {
-      if (!ORNCount) {
-        ORNCount.New();
-        OnUpdate([this](size_t){
-          ORNCount->Reset();
-          for (size_t i = 0; i < pop.size(); i++) {
-            if (IsOccupied(i)) {
-              if (pop[i]->getCPU().state.doneORN) { ORNCount->AddDatum(1); }
-            }
-          }
-        });
+  void TraceGenome(const sgpl::Program<Spec> & program, size_t n_cycles, std::ostream & out,
+                   uint64_t input_seed = 1) {
+    Sandbox sandbox(reward);
+    GenomeStore<Spec> sandbox_genomes;
+    CounterRandom test_inputs;
+    test_inputs.Reset(CounterRandom::MakeKey(input_seed, 0, 0));
+    uint32_t inputs[INPUT_WINDOW];
+    for (size_t i = 0; i < INPUT_WINDOW; i++) {
+      inputs[i] = test_inputs.GetUInt();
+    }
+    CPU<Spec> cpu(&sandbox, sandbox_genomes, 0, program, inputs);
+    cpu.Trace(n_cycles, cycles_per_org, input_seed, out);
+  }
+
+  /**
+   * @brief Writes a report of the most abundant genotypes in the population.
+   *
+   * Genotypes are ranked by how many organisms carry them with GetMostAbundantGenomes, and a
+   * second pass over the population merges the tasks their organisms have performed.
+   * Each genotype is listed with its abundance, share of the population, genome hash and
+   * tasks, followed by its program and, if trace_cycles is set, its execution trace on the
+   * test inputs of TraceGenome.
+   *
+   * @param filename The path of the text file to write.
+   * @param top How many genotypes to report.
+   * @param trace_cycles How many CPU cycles to trace each genotype for; 0 for no traces.
+   * @return bool Whether the file was written.
+   */
+  bool SaveGenotypes(const std::string & filename, size_t top, size_t trace_cycles) {
+    std::ofstream out(filename);
+    if (!out) {
+      std::cerr << "Could not open genotype file " << filename << std::endl;
+      return false;
+    }
+    const auto abundant = GetMostAbundantGenomes(top);
+    std::unordered_map<const genome_t *, size_t> ranks;
+    for (size_t rank = 0; rank < abundant.size(); rank++) {
+      ranks.emplace(abundant[rank].first, rank);
+    }
+    std::vector<uint32_t> tasks(abundant.size(), 0);
+    size_t num_orgs = 0;
+    for (size_t i = 0; i < pop.size(); i++) {
+      if (!IsOccupied(i)) {
+        continue;
+      }
+      num_orgs++;
+      auto rank = ranks.find(&pop[i]->getCPU().GetGenome());
+      if (rank != ranks.end()) {
+        tasks[rank->second] |= states.tasks_done[i];
       }
-      return *ORNCount;
+    }
+
+    out << "Update " << update << ": " << num_orgs << " organisms, "
+        << genomes.GetNumGenomes() << " distinct genotypes\n";
+    for (size_t rank = 0; rank < abundant.size(); rank++) {
+      const genome_t &genome = *abundant[rank].first;
+      const size_t organisms = abundant[rank].second;
+      out << "\n#" << rank + 1 << ": " << organisms << " organisms ("
+          << 100.0 * organisms / std::max<size_t>(num_orgs, 1) << "%), genome " << std::hex
+          << genome.hash << std::dec << ", " << genome.program.size()
+          << " instructions, tasks mask " << tasks[rank];
+      for (size_t task = 0; task < NUM_TASKS; task++) {
+        if ((tasks[rank] >> task) & 1) {
+          out << ' ' << TASK_NAMES[task];
+        }
+      }
+      out << '\n';
+      Sandbox sandbox(reward);
+      GenomeStore<Spec> sandbox_genomes;
+      const uint32_t no_inputs[INPUT_WINDOW] = {};
+      CPU<Spec>(&sandbox, sandbox_genomes, 0, genome.program, no_inputs).PrintGenome(out);
+      if (trace_cycles) {
+        out << "trace:\n";
+        TraceGenome(genome.program, trace_cycles, out);
+      }
+    }
+    return true;
   }
 
   /**
-   * @brief Retrieves the data monitor tracking the count of organisms with the 'AND' state.
+   * @brief Sets how much CPU time organisms get and how it is shared between them.
    *
-   * This function ensures that the data monitor for counting organisms whose state indicates 
-   * they have performed "AND" is properly instantiated and updated. On the first call, it initializes the 
-   * monitor and registers an update callback that iterates over the population to count relevant organisms.
+   * @param _cycles_per_org The average number of CPU cycles each organism runs per update.
+   * @param _merit_type What cycles are shared out in proportion to; with MERIT_NONE, every
+   * organism runs exactly _cycles_per_org cycles.
+   */
+  void SetScheduling(uint32_t _cycles_per_org, MeritType _merit_type) {
+    cycles_per_org = _cycles_per_org;
+    merit_type = _merit_type;
+  }
+
+  /**
+   * @brief Sets whether organisms that can never act again are skipped.
+   *
+   * An organism is dormant if its genome has no IO or Reproduce instruction, or once its CPU
+   * is found looping without executing an IO or a successful Reproduce; see CPU.h. Dormant
+   * organisms keep their cycle budgets and can still be replaced, but their CPUs are not
+   * run, which changes nothing else about the simulation. An organism stops being dormant
+   * when its genome or CPU is replaced.
    *
-   * @return emp::DataMonitor<int>& Reference to the data monitor tracking AND counts.
+   * @param skip Whether to skip dormant organisms.
    */
-  emp::DataMonitor<int> & GetANDCountDataNode() {
-      if (!ANDCount) {
-        ANDCount.New();
-        OnUpdate([this](size_t){
-          ANDCount->Reset();
-          for (size_t i = 0; i < pop.size(); i++) {
-            if (IsOccupied(i)) {
-              if (pop[i]->getCPU().state.doneAND) { ANDCount->AddDatum(1); }
-            }
-          }
-        });
+  void SetSkipDormant(bool skip) { skip_dormant = skip; }
+
+  /**
+   * @brief Returns the merit of the organism in a cell, which its CPU time is proportional to.
+   *
+   * Task merit is the points the organism's completed tasks are worth under the current
+   * reward condition, so every organism has a merit of at least the points for no tasks.
+   * Points merit is one more than the organism's current points.
+   *
+   * @param i The index of an occupied cell.
+   * @return double The organism's merit.
+   */
+  double GetMerit(size_t i) const {
+    if (merit_type == MERIT_POINTS) {
+      return 1.0 + states.points[i];
+    }
+    const uint32_t tasks_done = states.tasks_done[i];
+    return reward ? TASK_POINTS.all[tasks_done] : TASK_POINTS.equ_only[tasks_done];
+  }
+
+  /**
+   * @brief Shares out this update's CPU cycles in proportion to merit.
+   *
+   * The update's total budget, cycles_per_org for each living organism, is split so that
+   * each cell gets its expected share, total * merit / total merit, rounded down or up.
+   * One random offset rounds every share: walking the cells in order, each gets the whole
+   * cycles its share carries the running total (plus the offset) across. A share is
+   * therefore rounded up with probability equal to its fractional part, and the budgets
+   * add up to exactly the total, in a single linear pass. Unlike drawing cycles at random,
+   * a cell's budget never strays more than one cycle from its share. Empty cells have no
+   * merit and organisms left with no cycles are skipped entirely for the update. The
+   * offset comes from the world's random number generator on the calling thread, so the
+   * budgets do not depend on the thread count.
+   */
+  void AssignCycleBudgets() {
+    merits.assign(GetSize(), 0.0);
+    cycle_budgets.assign(GetSize(), 0);
+    size_t num_orgs = 0;
+    double total_merit = 0.0;
+    for (size_t i = 0; i < pop.size(); i++) {
+      if (IsOccupied(i)) {
+        merits[i] = GetMerit(i);
+        total_merit += merits[i];
+        num_orgs++;
       }
-      return *ANDCount;
+    }
+    if (!num_orgs || total_merit <= 0.0) {
+      return;
+    }
+    const double cycles_per_merit = static_cast<double>(num_orgs) * cycles_per_org / total_merit;
+    double running_total = GetRandom().GetDouble();
+    uint64_t assigned = 0;
+    for (size_t i = 0; i < merits.size(); i++) {
+      if (merits[i] <= 0.0) {
+        continue;
+      }
+      running_total += merits[i] * cycles_per_merit;
+      const uint64_t reached = static_cast<uint64_t>(running_total);
+      cycle_budgets[i] = reached - assigned;
+      assigned = reached;
+    }
   }
 
   /**
-   * @brief Retrieves the data monitor tracking the count of organisms with the 'NAND' state.
+   * @brief Returns the cycles each cell runs this update under merit scheduling.
    *
-   * This function ensures that the data monitor for counting organisms whose state indicates 
-   * they have performed "NAND" is properly instantiated and updated. On the first call, it initializes the 
-   * monitor and registers an update callback that iterates over the population to count relevant organisms.
+   * @return const emp::vector<uint32_t>& Budgets indexed by cell, from the last
+   * AssignCycleBudgets().
+   */
+  const emp::vector<uint32_t> &GetCycleBudgets() const { return cycle_budgets; }
+
+  /**
+   * @brief Counts how many organisms have performed each task in a single pass.
    *
-   * @return emp::DataMonitor<int>& Reference to the data monitor tracking NAND counts.
+   * The task bitmask array of the state store is swept once and every task counter is
+   * filled from the same visit to each cell, so the cost of data collection does not grow
+   * with the number of tasks tracked. Empty cells hold no tasks, so no occupancy check is
+   * needed. Any task data monitors that have been requested are then fed from the counter
+   * array.
    */
-  emp::DataMonitor<int> & GetNANDCountDataNode() {
-      if (!NANDCount) {
-        NANDCount.New();
-        OnUpdate([this](size_t){
-          NANDCount->Reset();
-          for (size_t i = 0; i < pop.size(); i++) {
-            if (IsOccupied(i)) {
-              if (pop[i]->getCPU().state.doneNAND) { NANDCount->AddDatum(1); }
-            }
-          }
-        });
+  void TakeCensus() {
+    task_counts.fill(0);
+    for (const uint32_t tasks_done : states.tasks_done) {
+      for (size_t task = 0; task < NUM_TASKS; task++) {
+        task_counts[task] += (tasks_done >> task) & 1;
+      }
+    }
+    for (size_t task = 0; task < NUM_TASKS; task++) {
+      if (task_count_nodes[task]) {
+        task_count_nodes[task]->Reset();
+        task_count_nodes[task]->AddDatum(task_counts[task]);
       }
-      return *NANDCount;
+    }
   }
 
   /**
-   * @brief Retrieves the data monitor tracking the count of organisms with the 'NOT' state.
+   * @brief Registers the census to run at the start of every update.
    *
-   * This function ensures that the data monitor for counting organisms whose state indicates 
-   * they have performed "NOT" is properly instantiated and updated. On the first call, it initializes the 
-   * monitor and registers an update callback that iterates over the population to count relevant organisms.
+   * Only one callback is ever registered, no matter how many tasks or data
+   * monitors are in use.
+   */
+  void SetupCensus() {
+    if (census_registered) {
+      return;
+    }
+    census_registered = true;
+    OnUpdate([this](size_t){
+      PhaseTimer timer(stats ? &stats->census_ns : nullptr);
+      TakeCensus();
+    });
+  }
+
+  /**
+   * @brief Packs the most recent census into a row for output.
    *
-   * @return emp::DataMonitor<int>& Reference to the data monitor tracking NOT counts.
+   * @param census_update The update the census was taken at.
+   * @return CensusRow The update number followed by each task count.
    */
-  emp::DataMonitor<int> & GetNOTCountDataNode() {
-      if (!NOTCount) {
-        NOTCount.New();
-        OnUpdate([this](size_t){
-          NOTCount->Reset();
-          for (size_t i = 0; i < pop.size(); i++) {
-            if (IsOccupied(i)) {
-              if (pop[i]->getCPU().state.doneNOT) { NOTCount->AddDatum(1); }
-            }
-          }
-        });
+  CensusRow MakeCensusRow(size_t census_update) const {
+    CensusRow row{static_cast<uint32_t>(census_update), {}};
+    for (size_t task = 0; task < NUM_TASKS; task++) {
+      row.counts[task] = task_counts[task];
+    }
+    return row;
+  }
+
+  /**
+   * @brief Returns the task counts from the most recent census.
+   *
+   * @return const std::array<int, NUM_TASKS>& Organism counts indexed by TaskId.
+   */
+  const std::array<int, NUM_TASKS> &GetTaskCounts() const { return task_counts; }
+
+  /**
+   * @brief Retrieves the data monitor tracking the count of organisms that have performed a task.
+   *
+   * On the first call for a given task the monitor is created and the shared census is
+   * registered; the monitor is then refreshed by the census every update.
+   *
+   * @param task The task to track.
+   * @return emp::DataMonitor<int>& Reference to the data monitor tracking the task's count.
+   */
+  emp::DataMonitor<int> & GetTaskCountDataNode(TaskId task) {
+      if (!task_count_nodes[task]) {
+        task_count_nodes[task].New();
+        SetupCensus();
       }
-      return *NOTCount;
+      return *task_count_nodes[task];
   }
 
   /**
@@ -270,122 +692,486 @@ public:
  *
  * This function is responsible for creating or initializing the data file that will be used 
  * to record simulation metrics and states over time. It may involve specifying file paths, 
- * creating file headers, and defining the structure of the logged data.
+ * creating file headers, and defining the structure of the logged data. The world owns the
+ * file and writes it from an update callback, so with instrumentation on its writes are
+ * timed as file writes.
+ *
+ * @param filename The path of the file to create.
+ * @param interval The file gets a row on every update that is a multiple of this.
+ * @return emp::DataFile& The world's file, for adding further columns or timing.
  */
-  emp::DataFile SetupDataFile(const std::string & filename) {
-    auto & file = SetupFile(filename);
-    auto & EQUNode = GetEQUCountDataNode();
-    auto & XORNode = GetXORCountDataNode();
-    auto & NORNode = GetNORCountDataNode();
-    auto & ANDNNode = GetANDNCountDataNode();
-    auto & ORNode = GetORCountDataNode();
-    auto & ORNNode = GetORNCountDataNode();
-    auto & ANDNode = GetANDCountDataNode();
-    auto & NANDNode = GetNANDCountDataNode();
-    auto & NOTNode = GetNOTCountDataNode();
+  emp::DataFile & SetupDataFile(const std::string & filename, size_t interval = 1) {
+    if (data_file) { data_file.Delete(); }
+    data_file = emp::NewPtr<emp::DataFile>(filename);
+    emp::DataFile & file = *data_file;
+    file.SetTimingRepeat(interval);
     file.AddVar(update, "update", "Update");
-    file.AddTotal(EQUNode, "EQU count", "Orgs that have successfully performed EQU");
-    file.AddTotal(XORNode, "XOR count", "Orgs that have successfully performed XOR");
-    file.AddTotal(NORNode, "NOR count", "Orgs that have successfully performed NOR");
-    file.AddTotal(ANDNNode, "ANDN count", "Orgs that have successfully performed ANDN");
-    file.AddTotal(ORNode, "OR count", "Orgs that have successfully performed OR");
-    file.AddTotal(ORNNode, "ORN count", "Orgs that have successfully performed ORN");
-    file.AddTotal(ANDNode, "AND count", "Orgs that have successfully performed AND");
-    file.AddTotal(NANDNode, "NAND count", "Orgs that have successfully performed NAND");
-    file.AddTotal(NOTNode, "NOT count", "Orgs that have successfully performed NOT");
+    for (size_t task = 0; task < NUM_TASKS; task++) {
+      const std::string name = TASK_NAMES[task];
+      file.AddTotal(GetTaskCountDataNode(static_cast<TaskId>(task)), name + " count",
+                    "Orgs that have successfully performed " + name);
+    }
     file.PrintHeaderKeys();
+    if (!data_file_registered) {
+      data_file_registered = true;
+      OnUpdate([this](size_t ud){
+        PhaseTimer timer(stats ? &stats->file_ns : nullptr);
+        data_file->Update(ud);
+      });
+    }
     return file;
   }
 
+  /**
+   * @brief Writes the complete state of the world to a checkpoint file.
+   *
+   * Must be called between updates. The checkpoint holds the size of the instruction set, the
+   * update number, the grid size, the raw state of both the world's emp::Random and
+   * SignalGP-Lite's sgpl::tlrand, the genome, task state and CPU registers of every
+   * organism, and the resource levels if resources are enabled, so a run resumed from it follows exactly the same trajectory as one that was
+   * never interrupted. The file is written under a temporary name and renamed into place, so
+   * an interrupted save never clobbers the previous checkpoint.
+   *
+   * @param filename The path of the checkpoint file.
+   */
+  void SaveCheckpoint(const std::string & filename) {
+    static_assert(std::is_trivially_copyable<emp::Random>::value, "Random state is checkpointed as raw bytes");
+    const std::string temp_filename = filename + ".tmp";
+    {
+      std::ofstream out(temp_filename, std::ios::binary | std::ios::trunc);
+      out.write(checkpoint::MAGIC, sizeof(checkpoint::MAGIC));
+      checkpoint::WriteRaw(out, checkpoint::VERSION);
+      checkpoint::WriteRaw(out, NUM_OPS);
+      checkpoint::WriteRaw(out, static_cast<uint64_t>(update));
+      checkpoint::WriteRaw(out, static_cast<uint64_t>(GetWidth()));
+      checkpoint::WriteRaw(out, static_cast<uint64_t>(GetHeight()));
+      checkpoint::WriteRaw(out, static_cast<uint64_t>(pop.size()));
+      checkpoint::WriteRaw(out, GetRandom());
+      checkpoint::WriteRaw(out, sgpl::tlrand.Get());
+      for (size_t i = 0; i < pop.size(); i++) {
+        const uint8_t occupied = IsOccupied(i);
+        checkpoint::WriteRaw(out, occupied);
+        if (occupied) {
+          pop[i]->Save(out);
+        }
+      }
+      const uint8_t has_resources = static_cast<bool>(resources);
+      checkpoint::WriteRaw(out, has_resources);
+      if (has_resources) {
+        const std::vector<float> &levels = resources->GetLevels();
+        out.write(reinterpret_cast<const char *>(levels.data()), levels.size() * sizeof(float));
+      }
+      if (!out) {
+        std::cerr << "Could not write checkpoint " << temp_filename << std::endl;
+        return;
+      }
+    }
+    std::rename(temp_filename.c_str(), filename.c_str());
+  }
+
+  /**
+   * @brief Restores a world saved with SaveCheckpoint.
+   *
+   * Should be called on a freshly constructed, empty world in place of seeding the initial
+   * population. Organisms are built straight from their saved genomes, and both random
+   * number generators are restored once every organism has been placed. Resources must be
+   * enabled if, and only if, they were when the checkpoint was saved.
+   *
+   * @param filename The path of the checkpoint file.
+   * @return bool Whether the checkpoint was read successfully.
+   */
+  bool LoadCheckpoint(const std::string & filename) {
+    std::ifstream in(filename, std::ios::binary);
+    char magic[sizeof(checkpoint::MAGIC)] = {};
+    uint32_t version = 0;
+    uint32_t num_ops = 0;
+    in.read(magic, sizeof(magic));
+    checkpoint::ReadRaw(in, version);
+    checkpoint::ReadRaw(in, num_ops);
+    if (!in || std::memcmp(magic, checkpoint::MAGIC, sizeof(magic)) || version != checkpoint::VERSION) {
+      std::cerr << filename << " is not a valid checkpoint." << std::endl;
+      return false;
+    }
+    if (num_ops != NUM_OPS) {
+      std::cerr << filename << " was saved with a different instruction set." << std::endl;
+      return false;
+    }
+    uint64_t saved_update = 0, width = 0, height = 0, size = 0;
+    checkpoint::ReadRaw(in, saved_update);
+    checkpoint::ReadRaw(in, width);
+    checkpoint::ReadRaw(in, height);
+    checkpoint::ReadRaw(in, size);
+    emp::Random world_random = GetRandom();
+    emp::Random sgpl_random = sgpl::tlrand.Get();
+    checkpoint::ReadRaw(in, world_random);
+    checkpoint::ReadRaw(in, sgpl_random);
+
+    if (width * height == size) {
+      Resize(width, height);
+    } else {
+      Resize(size);
+    }
+    for (size_t i = 0; i < size; i++) {
+      uint8_t occupied = 0;
+      checkpoint::ReadRaw(in, occupied);
+      if (occupied) {
+        AddOrgAt(emp::NewPtr<Organism<Spec>>(this, i, in), i);
+      }
+    }
+    uint8_t has_resources = 0;
+    checkpoint::ReadRaw(in, has_resources);
+    if (in && has_resources != static_cast<bool>(resources)) {
+      std::cerr << filename << " was saved with resources "
+                << (has_resources ? "enabled" : "disabled") << "." << std::endl;
+      return false;
+    }
+    if (resources) {
+      std::vector<float> &levels = resources->GetLevels();
+      in.read(reinterpret_cast<char *>(levels.data()), levels.size() * sizeof(float));
+    }
+    if (!in) {
+      std::cerr << "Checkpoint " << filename << " is truncated." << std::endl;
+      return false;
+    }
+    GetRandom() = world_random;
+    sgpl::tlrand.Get() = sgpl_random;
+    update = saved_update;
+    return true;
+  }
+
+  /**
+   * @brief Sets up a census data file written outside of emp::DataFile.
+   *
+   * The file holds the same columns as SetupDataFile's, one row every interval updates. It is either
+   * comma-separated text identical to SetupDataFile's output, or the binary columnar layout
+   * described in CensusFile.h, which convert_data.cpp turns back into text. When async is
+   * set, rows are handed to a background writer thread so file I/O never runs on the
+   * update loop. Calling it again replaces the file rather than adding a second one.
+   *
+   * @param filename The path of the file to create.
+   * @param binary Whether to write the binary columnar format.
+   * @param async Whether to write from a background thread.
+   * @param resume_update When resuming from a checkpoint, the update it was taken at; rows
+   * already in the file from before that update are kept.
+   * @param interval The file gets a row on every update that is a multiple of this, as with
+   * SetupDataFile.
+   */
+  void SetupCensusFile(const std::string & filename, bool binary, bool async,
+                       size_t resume_update = 0, size_t interval = 1) {
+    if (census_file) { census_file.Delete(); }
+    census_file_interval = interval;
+    emp::Ptr<CensusOutput> file;
+    if (binary) {
+      file = emp::NewPtr<BinaryCensusFile>(filename, resume_update);
+    } else {
+      file = emp::NewPtr<TextCensusFile>(filename, resume_update);
+    }
+    if (async) {
+      census_file = emp::NewPtr<AsyncCensusWriter>(file);
+    } else {
+      census_file = file;
+    }
+    SetupCensus();
+    if (!census_file_registered) {
+      census_file_registered = true;
+      OnUpdate([this](size_t ud){
+        PhaseTimer timer(stats ? &stats->file_ns : nullptr);
+        if (ud % census_file_interval == 0) {
+          census_file->Write(MakeCensusRow(ud));
+        }
+      });
+    }
+  }
+
+  /**
+   * @brief Turns on timing and counting of the update loop.
+   *
+   * Until this is called instrumentation costs a null check per phase and a flag check
+   * per IO instruction.
+   *
+   * @param filename The file to write one line of JSON to every interval, with the
+   * statistics gathered since the previous line.
+   * @param interval How many updates each line covers.
+   * @param append Whether to add to an existing log, as when resuming from a checkpoint,
+   * rather than starting a new one.
+   * @return bool Whether the log file could be opened.
+   */
+  bool EnableStats(const std::string & filename, size_t interval, bool append = false) {
+    stats_log.open(filename, append ? std::ios::app : std::ios::trunc);
+    if (!stats_log) {
+      std::cerr << "Could not open stats file " << filename << std::endl;
+      return false;
+    }
+    if (!stats) { stats = emp::NewPtr<UpdateStats>(); }
+    stats_interval = interval ? interval : 1;
+    instrumented = true;
+    return true;
+  }
+
+  /**
+   * @brief Writes the statistics gathered since the last log line and adds them to the
+   * run's totals.
+   */
+  void FlushStats() {
+    if (!stats || !stats->updates) {
+      return;
+    }
+    stats->WriteJson(stats_log, update);
+    stats_log.flush();
+    total_stats.Add(*stats);
+    *stats = UpdateStats{};
+  }
+
+  /**
+   * @brief Prints timings and counters totalled over every instrumented update.
+   *
+   * @param out The stream to print to.
+   */
+  void PrintStatsSummary(std::ostream & out) {
+    FlushStats();
+    total_stats.PrintSummary(out);
+  }
+
+  /**
+   * @brief Starts logging hashes of the population and random number generators after
+   * every update, in the format described in ReplayLog.h.
+   *
+   * @param filename The replay log to write.
+   * @return bool Whether the log could be opened.
+   */
+  bool EnableReplayLog(const std::string & filename) {
+    if (replay_log) { replay_log.Delete(); }
+    replay_log = emp::NewPtr<ReplayLogWriter>(filename);
+    if (!replay_log->IsOpen()) {
+      replay_log.Delete();
+      replay_log = nullptr;
+      return false;
+    }
+    return true;
+  }
+
+  /**
+   * @brief Hashes everything about a cell that a run's future depends on and that
+   * divergence shows up in first: its organism's genome, points, completed tasks,
+   * inputs and how far its random stream has been drawn.
+   *
+   * @param cell The cell to hash.
+   * @return uint32_t The hash, 0 only for empty cells.
+   */
+  uint32_t HashCell(size_t cell) const {
+    if (!pop[cell]) {
+      return 0;
+    }
+    uint64_t points_bits = 0;
+    std::memcpy(&points_bits, &states.points[cell], sizeof(double));
+    uint64_t hash = CounterRandom::Mix(pop[cell]->getCPU().GetGenomeHash() ^
+                                       pop[cell]->GetState().rng.counter);
+    hash = CounterRandom::Mix(hash ^ points_bits);
+    hash = CounterRandom::Mix(hash ^ states.tasks_done[cell] ^
+                              (uint64_t{states.input_idx[cell]} << 32));
+    hash ^= CounterRandom::HashBytes(&states.inputs[cell * INPUT_WINDOW],
+                                     INPUT_WINDOW * sizeof(uint32_t));
+    return static_cast<uint32_t>(hash ^ (hash >> 32)) | 1;
+  }
+
+  /**
+   * @brief Appends the current update's hashes to the replay log.
+   */
+  void WriteReplayRecord() {
+    replay_record.update = update;
+    replay_record.world_random = CounterRandom::HashBytes(&GetRandom(), sizeof(emp::Random));
+    replay_record.sgpl_random =
+        CounterRandom::HashBytes(&sgpl::tlrand.Get(), sizeof(emp::Random));
+    replay_record.width = GetWidth();
+    replay_record.cells.resize(GetSize());
+    for (size_t cell = 0; cell < GetSize(); cell++) {
+      replay_record.cells[cell] = HashCell(cell);
+    }
+    replay_record.population = CounterRandom::HashBytes(
+        replay_record.cells.data(), replay_record.cells.size() * sizeof(uint32_t));
+    replay_log->Write(replay_record);
+  }
+
   /**
    * @brief Processes each organism in the world.
    *
    * This function generates a random permutation of the grid positions and calls the 
-   * Process() method on each occupied organism in the shuffled order.
+   * Process() method on each occupied organism, giving it either the fixed number of
+   * cycles or its merit-scheduled budget. With a thread pool, threads claim chunks
+   * of the schedule as they finish earlier ones. Afterwards the reproduction queue is
+   * filled in schedule order, so it matches a serial run exactly.
    */
   void CallProcess() {
     emp::vector<size_t> schedule = emp::GetPermutation(GetRandom(), GetSize());
-    for (int i : schedule) {
-      if (!IsOccupied(i)) {
-        continue;
+    reproduce_requests.assign(GetSize(), 0);
+    if (merit_type != MERIT_NONE) {
+      AssignCycleBudgets();
+    }
+
+    auto process_range = [this, &schedule](size_t begin, size_t end) {
+      for (size_t idx = begin; idx < end; idx++) {
+        size_t i = schedule[idx];
+        if (!IsOccupied(i)) {
+          continue;
+        }
+        const uint32_t n_cycles = merit_type == MERIT_NONE ? cycles_per_org : cycle_budgets[i];
+        if (n_cycles) {
+          if (instrumented) {
+            const bool skipped = skip_dormant && pop[i]->IsDormant();
+            (skipped ? execution_counters.dormant_cycles : execution_counters.cycles) += n_cycles;
+          }
+          pop[i]->Process(CounterRandom::MakeKey(seed, update, i), n_cycles);
+        }
+      }
+    };
+    // Each thread counts into its own execution_counters and merges them once at the end
+    auto merge_counters = [this]() {
+      if (stats) {
+        std::lock_guard<std::mutex> lock(stats_mutex);
+        stats->AddCounters(execution_counters);
+      }
+    };
+
+    if (thread_pool) {
+      std::atomic<size_t> next_chunk{0};
+      thread_pool->Run([&](size_t) {
+        execution_counters = ExecutionCounters{};
+        for (size_t begin = next_chunk.fetch_add(PROCESS_CHUNK); begin < schedule.size();
+             begin = next_chunk.fetch_add(PROCESS_CHUNK)) {
+          process_range(begin, std::min(begin + PROCESS_CHUNK, schedule.size()));
+        }
+        merge_counters();
+      });
+    } else {
+      execution_counters = ExecutionCounters{};
+      process_range(0, schedule.size());
+      merge_counters();
+    }
+
+    for (size_t i : schedule) {
+      for (uint32_t request = 0; request < reproduce_requests[i]; request++) {
+        reproduce_queue.push_back(i);
       }
-      pop[i]->Process(i);
     }
   }
 
   /**
-   * @brief Updates the state of the world and processes reproduction.
+   * @brief Chooses the taxon of a newborn organism.
    *
-   * This function performs the world update by:
-   *  - Calling the base class update to handle standard update tasks.
-   *  - Processing each organism by invoking CallProcess().
-   *  - Then iterating over the reproduction queue to allow organisms that have signaled reproduction 
-   *    to produce offspring. If an organism is found at the queued location and its reproduction check 
-   *    succeeds, a new offspring is created via DoBirth().
+   * Must be called before the parent's cell is updated, as the parent may have been
+   * replaced by the offspring.
+   *
+   * @param parent_pos The parent's cell.
+   * @param parent_genome The parent's program, taken before the birth.
+   * @param offspring The newborn organism.
+   * @return uint32_t The parent's taxon if the genome is unchanged, otherwise a new child taxon.
    */
-  void Update() {
-    emp::World<Organism>::Update();
-    // Process each organism
-    CallProcess();
-    // Time to allow reproduction for any organisms that ran the reproduce instruction
-    for (emp::WorldPosition location : reproduce_queue) {
-      if (!IsOccupied(location)) {
-        return;
-      }
-      std::optional<Organism> offspring =
-          pop[location.GetIndex()]->CheckReproduction();
-      if (offspring.has_value()) {
-        DoBirth(offspring.value(), location.GetIndex());
-      }
+  uint32_t OffspringTaxon(size_t parent_pos, const sgpl::Program<Spec> *parent_genome,
+                          const Organism<Spec> &offspring) {
+    const uint32_t parent_taxon = cell_taxa[parent_pos];
+    if (&offspring.getCPU().GetProgram() == parent_genome) {
+      return parent_taxon;
     }
-    reproduce_queue.clear();
+    return phylogeny->AddChild(parent_taxon, update);
   }
 
   /**
-   * @brief Evaluates a given output against all registered tasks and updates the organism's state.
+   * @brief Places a mutated offspring of the organism at parent_pos.
    *
-   * This function iterates over each Task in the tasks container and calls its CheckOutput
-   * method using the provided output value and the organism's last input values. Depending on the 
-   * value of the reward parameter, either calculates whether an organism earns points for having
-   * completed any of the nine tasks and rewards it accordingly, or calculates whether an organism
-   * has completed the EQU task and rewards it accordingly.
+   * The birth position is chosen by the world's placement function, as DoBirth would. If
+   * that cell is occupied, the organism living there is overwritten in place: its CPU and
+   * genome buffers are reused and the parent's genome is copied into them exactly once.
+   * A birth into an empty cell copies the parent's genome once and mutates the copy in place.
+   * In-place replacement does not trigger the world's death and placement signals, so it
+   * updates lineage tracking itself.
    *
-   * @param reward A boolean value indicating reward-all or reward-none condition.
-   * @param output The output value produced by an organism.
-   * @param state The current state of the organism that will be updated based on the task outcomes.
+   * @param parent_pos The index of the reproducing organism.
    */
-  void CheckOutput(bool reward, uint32_t output, OrgState &state) {
-    for (Task* task: tasks) {
-        double task_points = task->CheckOutput(output, state.last_inputs);
-        if (reward) { state.points += task_points; } // reward-all condition
-        else { // reward-none condition
-            if (task == tasks[0]) { state.points += task_points; }
-            else { state.points += 1.0; }
-        }
-        if (task_points == 320.0) { state.doneEQU = true; }
-        else if (task_points == 161.0) { state.doneXOR = true; }
-        else if (task_points == 160.0) { state.doneNOR = true; }
-        else if (task_points == 81.0) { state.doneANDN = true; }
-        else if (task_points == 80.0) { state.doneOR = true; }
-        else if (task_points == 41.0) { state.doneORN = true; }
-        else if (task_points == 40.0) { state.doneAND = true; }
-        else if (task_points == 21.0) { state.doneNAND = true; }
-        else if (task_points == 20.0) { state.doneNOT = true; }
+  void BirthInPlace(size_t parent_pos) {
+    // Placement functions only look at the parent position, never at the organism
+    emp::WorldPosition pos = fun_find_birth_pos(pop[parent_pos], parent_pos);
+    if (!pos.IsValid()) {
+      return;
+    }
+    // Genomes are shared, so the offspring has the same program object if it is unmutated
+    const sgpl::Program<Spec> *parent_genome = &pop[parent_pos]->getCPU().GetProgram();
+    if (IsOccupied(pos)) {
+      const size_t cell = pos.GetIndex();
+      const uint32_t replaced_tasks = states.tasks_done[cell];
+      pop[cell]->InheritFrom(*pop[parent_pos]);
+      if (phylogeny) {
+        const uint32_t replaced_taxon = cell_taxa[cell];
+        cell_taxa[cell] = OffspringTaxon(parent_pos, parent_genome, *pop[cell]);
+        phylogeny->AddOrg(cell_taxa[cell]);
+        phylogeny->RemoveOrg(replaced_taxon, replaced_tasks);
+      }
+      return;
     }
+    emp::Ptr<Organism<Spec>> offspring =
+        emp::NewPtr<Organism<Spec>>(*pop[parent_pos], pos.GetIndex());
+    if (phylogeny) {
+      cell_taxa[pos.GetIndex()] = OffspringTaxon(parent_pos, parent_genome, *offspring);
+    }
+    AddOrgAt(offspring, pos, parent_pos);
   }
 
   /**
-   * @brief Queues an organism for reproduction at a specified world location.
+   * @brief Updates the state of the world and processes reproduction.
    *
-   * This function adds the provided world position to the reproduction queue. Reproduction is
-   * delayed until after all organisms have been processed, avoiding potential conflicts such as
-   * a child organism overwriting its parent during the same update cycle.
+   * This function performs the world update by:
+   *  - Calling the base class update to handle standard update tasks.
+   *  - Processing each organism by invoking CallProcess().
+   *  - Then iterating over the reproduction queue to allow organisms that have signaled reproduction 
+   *    to produce offspring, which BirthInPlace() writes directly into the target cell.
+   *  - Diffusing and replenishing resources, if enabled.
+   *  - Appending the update's hashes to the replay log, if one is open.
    *
-   * @param location The world position where the reproduction event will occur.
+   * With instrumentation enabled each phase is timed, and a line of statistics is logged
+   * every stats_interval updates.
    */
-  void ReproduceOrg(emp::WorldPosition location) {
-    reproduce_queue.push_back(location);
+  void Update() {
+    {
+      PhaseTimer timer(stats ? &stats->base_ns : nullptr);
+      base_t::Update();
+    }
+    // Process each organism
+    {
+      PhaseTimer timer(stats ? &stats->process_ns : nullptr);
+      CallProcess();
+    }
+    // Time to allow reproduction for any organisms that ran the reproduce instruction
+    {
+      PhaseTimer timer(stats ? &stats->birth_ns : nullptr);
+      size_t births = 0;
+      for (emp::WorldPosition location : reproduce_queue) {
+        if (!IsOccupied(location)) {
+          continue;
+        }
+        BirthInPlace(location.GetIndex());
+        births++;
+      }
+      if (stats) {
+        stats->births += births;
+        stats->queue_length += reproduce_queue.size();
+        stats->max_queue_length = std::max<uint64_t>(stats->max_queue_length,
+                                                     reproduce_queue.size());
+      }
+    }
+    reproduce_queue.clear();
+    if (resources) {
+      PhaseTimer timer(stats ? &stats->resource_ns : nullptr);
+      resources->Update();
+    }
+    if (replay_log) {
+      WriteReplayRecord();
+    }
+    if (stats) {
+      stats->updates++;
+      if (update % stats_interval == 0) {
+        FlushStats();
+      }
+    }
   }
 };
 
-#endif
\ No newline at end of file
+#endif
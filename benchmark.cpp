@@ -0,0 +1,352 @@
+// Compile and run with `./compile-run-bench.sh`, or
+// `c++ -O3 -DNDEBUG -std=c++17 -pthread -Isignalgp-lite/third-party/Empirical/include/ -Isignalgp-lite/include/ benchmark.cpp -o benchmark`
+//
+// Micro and macro benchmarks for the simulation hot paths. Each benchmark
+// reports nanoseconds and heap allocations per operation; results are printed
+// as a table and written as JSON (to benchmark.json, or the path given as the
+// first argument) so runs can be diffed across versions.
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "World.h"
+
+// Every heap allocation in the process goes through these, so allocations per
+// operation can be reported without an external profiler. All the replaceable
+// forms are defined, and kept out of line, so every new is matched by a delete
+// from the same set.
+std::atomic<size_t> allocation_count{0};
+
+[[gnu::noinline]] void *CountedAllocate(size_t size) {
+  allocation_count.fetch_add(1, std::memory_order_relaxed);
+  return std::malloc(size ? size : 1);
+}
+
+[[gnu::noinline]] void CountedFree(void *ptr) noexcept { std::free(ptr); }
+
+[[gnu::noinline]] void *operator new(size_t size) {
+  if (void *ptr = CountedAllocate(size)) {
+    return ptr;
+  }
+  throw std::bad_alloc();
+}
+[[gnu::noinline]] void *operator new[](size_t size) { return operator new(size); }
+[[gnu::noinline]] void *operator new(size_t size, const std::nothrow_t &) noexcept {
+  return CountedAllocate(size);
+}
+[[gnu::noinline]] void *operator new[](size_t size, const std::nothrow_t &) noexcept {
+  return CountedAllocate(size);
+}
+[[gnu::noinline]] void operator delete(void *ptr) noexcept { CountedFree(ptr); }
+[[gnu::noinline]] void operator delete[](void *ptr) noexcept { CountedFree(ptr); }
+[[gnu::noinline]] void operator delete(void *ptr, size_t) noexcept { CountedFree(ptr); }
+[[gnu::noinline]] void operator delete[](void *ptr, size_t) noexcept { CountedFree(ptr); }
+[[gnu::noinline]] void operator delete(void *ptr, const std::nothrow_t &) noexcept {
+  CountedFree(ptr);
+}
+[[gnu::noinline]] void operator delete[](void *ptr, const std::nothrow_t &) noexcept {
+  CountedFree(ptr);
+}
+
+// Benchmarks run the default treatment's instruction set
+using Spec = NandXorSpec;
+
+// Results are written here so the compiler cannot discard benchmarked work
+volatile uint64_t sink;
+
+struct BenchResult {
+  std::string name;
+  size_t ops;
+  double ns_per_op;
+  double allocs_per_op;
+};
+
+std::vector<BenchResult> results;
+
+/**
+ * @brief Times a benchmark body and records the result.
+ *
+ * The body is run once untimed to warm caches, then `ops` times.
+ *
+ * @param name The benchmark's name in the report.
+ * @param ops How many operations to time.
+ * @param body The operation; called with the operation index.
+ */
+void Bench(const std::string &name, size_t ops, const std::function<void(size_t)> &body) {
+  body(0);
+  const size_t allocs_before = allocation_count.load();
+  const auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < ops; i++) {
+    body(i);
+  }
+  const auto stop = std::chrono::steady_clock::now();
+  const size_t allocs = allocation_count.load() - allocs_before;
+  const double ns = std::chrono::duration<double, std::nano>(stop - start).count();
+  results.push_back({name, ops, ns / ops, static_cast<double>(allocs) / ops});
+  std::cout << std::left << std::setw(36) << name << std::right << std::setw(14) << std::fixed
+            << std::setprecision(1) << ns / ops << " ns/op" << std::setw(12) << std::setprecision(2)
+            << static_cast<double>(allocs) / ops << " allocs/op" << std::setw(14)
+            << std::setprecision(1) << 1e9 * ops / ns << " ops/s" << std::endl;
+}
+
+/**
+ * @brief Builds a full world of random ancestors.
+ */
+void FillWorld(OrgWorld<Spec> &world, size_t width, size_t height, size_t threads) {
+  world.SetReward(true);
+  world.SetSeed(1);
+  world.SetThreads(threads);
+  world.SetPopStruct_Grid(width, height);
+  for (size_t i = 0; i < width * height; i++) {
+    world.AddOrgAt(emp::NewPtr<Organism<Spec>>(&world, i), i);
+  }
+  world.SetupCensus();
+}
+
+/**
+ * The per-task checks the simulation made before the compile-time task set: NOT
+ * looks for an input the output is the complement of, and every other task for
+ * two adjacent inputs the output is the task's function of. A match pays the
+ * task's reward, and anything else the 1 point for failing. Kept as the
+ * baseline the task benchmarks compare against, called through a table of
+ * function pointers like the virtual calls they replaced.
+ */
+using LegacyTaskCheck = double (*)(uint32_t output, const uint32_t inputs[4]);
+
+double LegacyNOT(uint32_t output, const uint32_t inputs[4]) {
+  for (size_t i = 0; i < 4; i++) {
+    if (~inputs[i] == output) {
+      return 20.0;
+    }
+  }
+  return 1.0;
+}
+
+template <uint32_t (*OP)(uint32_t, uint32_t), int REWARD>
+double LegacyPairCheck(uint32_t output, const uint32_t inputs[4]) {
+  for (size_t i = 0; i < 3; i++) {
+    if (OP(inputs[i], inputs[i + 1]) == output) {
+      return REWARD;
+    }
+  }
+  return 1.0;
+}
+
+uint32_t LegacyNand(uint32_t a, uint32_t b) { return ~(a & b); }
+uint32_t LegacyAnd(uint32_t a, uint32_t b) { return a & b; }
+uint32_t LegacyOrn(uint32_t a, uint32_t b) { return a | ~b; }
+uint32_t LegacyOr(uint32_t a, uint32_t b) { return a | b; }
+uint32_t LegacyAndn(uint32_t a, uint32_t b) { return a & ~b; }
+uint32_t LegacyNor(uint32_t a, uint32_t b) { return ~(a | b); }
+uint32_t LegacyXor(uint32_t a, uint32_t b) { return a ^ b; }
+uint32_t LegacyEqu(uint32_t a, uint32_t b) { return ~(a ^ b); }
+
+const LegacyTaskCheck LEGACY_TASK_CHECKS[] = {
+    LegacyPairCheck<LegacyEqu, 320>, LegacyPairCheck<LegacyXor, 161>,
+    LegacyPairCheck<LegacyNor, 160>, LegacyPairCheck<LegacyAndn, 81>,
+    LegacyPairCheck<LegacyOr, 80>,   LegacyPairCheck<LegacyOrn, 41>,
+    LegacyPairCheck<LegacyAnd, 40>,  LegacyPairCheck<LegacyNand, 21>,
+    LegacyNOT};
+
+/**
+ * @brief Task scoring: the legacy per-task checks against the compile-time
+ * task set evaluating the same window, and the precomputed candidates the simulation
+ * uses, including keeping them up to date.
+ */
+void BenchTasks() {
+  emp::Random random(1);
+  std::vector<uint32_t> values(4096 + 4);
+  for (uint32_t &value : values) {
+    // Small values so that a useful fraction of outputs perform some task
+    value = random.GetUInt(4);
+  }
+  const size_t mask = 4095;
+
+  Bench("legacy task checks (9 indirect calls)", 2000000, [&](size_t i) {
+    double points = 0;
+    for (LegacyTaskCheck check : LEGACY_TASK_CHECKS) {
+      points += check(values[(i + 4) & mask], &values[i & mask]);
+    }
+    sink = points;
+  });
+  Bench("Tasks::Evaluate (unrolled TaskSet) + points", 2000000, [&](size_t i) {
+    sink = TASK_POINTS.all[Tasks::Evaluate(values[(i + 4) & mask], &values[i & mask])];
+  });
+  Bench("Tasks::Evaluate (unrolled TaskSet)", 2000000, [&](size_t i) {
+    sink = Tasks::Evaluate(values[(i + 4) & mask], &values[i & mask]);
+  });
+  OrgStateStore store;
+  store.Resize(1);
+  Bench("UpdateCandidates + MatchOutput", 2000000, [&](size_t i) {
+    const size_t slot = i % INPUT_WINDOW;
+    store.inputs[slot] = values[i & mask];
+    store.UpdateCandidates(0, slot);
+    sink = store.MatchOutput(0, values[(i + 4) & mask]);
+  });
+}
+
+/**
+ * @brief Single-instruction and single-organism costs.
+ */
+void BenchOrganism() {
+  emp::Random random(1);
+  OrgWorld<Spec> world(random);
+  FillWorld(world, 1, 1, 1);
+  world.Update();
+
+  // The standalone CPU runs against a sandbox, so its task state never lands in the
+  // world organism's cell
+  Sandbox sandbox(true);
+  GenomeStore<Spec> sandbox_genomes;
+  CPU<Spec> cpu(&sandbox, sandbox_genomes, 0);
+  sgpl::Core<Spec> core;
+  sgpl::Instruction<Spec> inst{};
+  inst.args[0] = 0;
+  const sgpl::Program<Spec> program(1);
+  Bench("IOInstruction::run", 1000000, [&](size_t) {
+    IOInstruction::run<Spec>(core, inst, program, cpu.state);
+  });
+
+  Bench("CPU::RunCPUStep(10)", 200000, [&](size_t) { cpu.RunCPUStep(10); });
+
+  const Organism<Spec> &org = *world.GetPopulation()[0];
+  Bench("copy CPU (old getCPU by value)", 100000, [&](size_t) {
+    CPU<Spec> copy = org.getCPU();
+    sink = copy.state.GetTasksDone();
+  });
+  Bench("Organism::GetState", 100000, [&](size_t) { sink = org.GetState().GetTasksDone(); });
+}
+
+/**
+ * @brief Counts task completions the way the census did before organism state could be
+ * read in place: one copy of each organism's CPU per task, as Organism::getCPU() used to
+ * return by value.
+ */
+int CopyingCensus(OrgWorld<Spec> &world) {
+  int count = 0;
+  for (size_t task = 0; task < NUM_TASKS; task++) {
+    for (size_t i = 0; i < world.GetSize(); i++) {
+      if (world.IsOccupied(i)) {
+        const CPU<Spec> cpu = world.GetPopulation()[i]->getCPU();
+        count += cpu.state.IsDone(task);
+      }
+    }
+  }
+  return count;
+}
+
+/**
+ * @brief Whole-world costs at several grid sizes and thread counts.
+ */
+void BenchWorld() {
+  for (size_t side : {30, 60, 120, 240}) {
+    emp::Random random(1);
+    OrgWorld<Spec> world(random);
+    FillWorld(world, side, side, 1);
+    const std::string grid = std::to_string(side) + "x" + std::to_string(side);
+    Bench("OrgWorld::Update " + grid, 3600000 / (side * side) + 5,
+          [&](size_t) { world.Update(); });
+    if (side == 60) {
+      // Allocations per update on the old path, for comparison with the line above
+      Bench("OrgWorld::Update " + grid + " + CPU-copying census", 200, [&](size_t) {
+        world.Update();
+        sink = CopyingCensus(world);
+      });
+    }
+    Bench("census " + grid, 200, [&](size_t) { world.TakeCensus(); });
+    Bench("OrgWorld::BirthInPlace " + grid, 20000,
+          [&](size_t i) { world.BirthInPlace(i % world.GetSize()); });
+  }
+
+  {
+    emp::Random random(1);
+    OrgWorld<Spec> world(random);
+    FillWorld(world, 120, 120, 1);
+    world.EnablePhylogeny();
+    Bench("OrgWorld::Update 120x120 phylogeny", 200, [&](size_t) { world.Update(); });
+  }
+
+  {
+    emp::Random random(1);
+    OrgWorld<Spec> world(random);
+    FillWorld(world, 120, 120, 1);
+    world.EnableResources(ResourceSettings{});
+    Bench("OrgWorld::Update 120x120 resources", 200, [&](size_t) { world.Update(); });
+  }
+
+  {
+    emp::Random random(1);
+    OrgWorld<Spec> world(random);
+    FillWorld(world, 120, 120, 1);
+    world.SetSkipDormant(true);
+    Bench("OrgWorld::Update 120x120 skip dormant", 200, [&](size_t) { world.Update(); });
+  }
+
+  {
+    emp::Random random(1);
+    OrgWorld<Spec> world(random);
+    FillWorld(world, 1000, 1000, 1);
+    Bench("OrgWorld::SaveGenotypes 1000x1000 top 10", 5,
+          [&](size_t) { world.SaveGenotypes("benchmark_genotypes.txt", 10, 0); });
+    std::remove("benchmark_genotypes.txt");
+  }
+
+  {
+    ResourceGrid grid{ResourceSettings{}};
+    grid.Resize(1000, 1000);
+    Bench("ResourceGrid::Update 1000x1000", 20, [&](size_t) { grid.Update(); });
+  }
+
+  for (MeritType merit : {MERIT_TASKS, MERIT_POINTS}) {
+    emp::Random random(1);
+    OrgWorld<Spec> world(random);
+    FillWorld(world, 120, 120, 1);
+    world.SetScheduling(10, merit);
+    Bench("OrgWorld::Update 120x120 merit=" + std::to_string(merit), 200,
+          [&](size_t) { world.Update(); });
+  }
+
+  const size_t max_threads = std::max(1u, std::thread::hardware_concurrency());
+  for (size_t threads = 1; threads <= max_threads; threads *= 2) {
+    emp::Random random(1);
+    OrgWorld<Spec> world(random);
+    FillWorld(world, 240, 240, threads);
+    Bench("OrgWorld::Update 240x240 threads=" + std::to_string(threads), 20,
+          [&](size_t) { world.Update(); });
+  }
+}
+
+/**
+ * @brief Writes all results as JSON.
+ */
+void WriteJson(const std::string &filename) {
+  std::ofstream out(filename);
+  out << "{\n  \"benchmarks\": [\n";
+  for (size_t i = 0; i < results.size(); i++) {
+    const BenchResult &result = results[i];
+    out << "    {\"name\": \"" << result.name << "\", \"ops\": " << result.ops
+        << ", \"ns_per_op\": " << result.ns_per_op
+        << ", \"ops_per_second\": " << 1e9 / result.ns_per_op
+        << ", \"allocs_per_op\": " << result.allocs_per_op << "}"
+        << (i + 1 < results.size() ? ",\n" : "\n");
+  }
+  out << "  ]\n}\n";
+}
+
+int main(int argc, char *argv[]) {
+  sgpl::tlrand.Get().ResetSeed(2);
+  BenchTasks();
+  BenchOrganism();
+  BenchWorld();
+  WriteJson(argc > 1 ? argv[1] : "benchmark.json");
+}
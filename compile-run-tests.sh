@@ -0,0 +1,2 @@
+g++ -O2 -Wall -Wno-unused-function -std=c++17 -pthread -Isignalgp-lite/third-party/Empirical/include/ -Isignalgp-lite/include/ tests.cpp -o tests
+./tests
@@ -1,2 +1,2 @@
-g++ -O3 -DNDEBUG -march=native -Wall -Wno-unused-function -std=c++17 -Isignalgp-lite/third-party/Empirical/include/ -Isignalgp-lite/include/ native.cpp -o native_project
+g++ -O3 -DNDEBUG -march=native -Wall -Wno-unused-function -std=c++17 -pthread -Isignalgp-lite/third-party/Empirical/include/ -Isignalgp-lite/include/ native.cpp -o native_project
 ./native_project
\ No newline at end of file
@@ -0,0 +1,23 @@
+// Compile with `c++ -std=c++17 -O2 convert_data.cpp -o convert_data`
+//
+// Converts a binary data file written with BINARY_DATA set back into the
+// comma-separated text format of the regular data file.
+
+#include <fstream>
+#include <iostream>
+
+#include "CensusFile.h"
+
+int main(int argc, char *argv[]) {
+  if (argc != 3) {
+    std::cerr << "Usage: " << argv[0] << " <binary input> <text output>" << std::endl;
+    return 1;
+  }
+  BinaryCensusReader reader(argv[1]);
+  if (!reader.IsValid()) {
+    std::cerr << argv[1] << " is not a valid binary data file." << std::endl;
+    return 1;
+  }
+  std::ofstream out(argv[2]);
+  reader.PrintText(out);
+}
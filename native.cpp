@@ -1,12 +1,22 @@
 // Compile with `c++ -std=c++17 -Isignalgp-lite/include native.cpp`
 
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <fstream>
 #include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
 #include "emp/config/ArgManager.hpp"
 
 #include "World.h"
 #include "ConfigSetup.h"
 
 MyConfigType config;
+// Set by --resume: continue from CHECKPOINT_FILE instead of starting fresh
+bool resume = false;
 
 /**
  * @brief Initializes the configuration settings for the simulation.
@@ -15,12 +25,23 @@ MyConfigType config;
  * be read, it writes a new configuration file with default settings and reads it again.
  * It then processes command line options to override any settings from the configuration file.
  * If any errors are encountered during processing (either in the options file or due to unknown arguments),
- * an error message is printed and the program exits.
+ * an error message is printed and the program exits. The --resume flag is removed from the arguments
+ * before they are processed.
  *
  * @param argc The number of command-line arguments.
  * @param argv The array of command-line arguments.
  */
 void InitializeConfig(int argc, char *argv[]) {
+  int kept_args = 0;
+  for (int i = 0; i < argc; i++) {
+    if (std::string(argv[i]) == "--resume") {
+      resume = true;
+    } else {
+      argv[kept_args++] = argv[i];
+    }
+  }
+  argc = kept_args;
+
   bool success = config.Read("MySettings.cfg");
   if (!success) { config.Write("MySettings.cfg"); }
   config.Read("MySettings.cfg");
@@ -34,6 +55,89 @@ void InitializeConfig(int argc, char *argv[]) {
     std::cerr << "Leftover args no good." << std::endl;
     exit(1);
   }
+  if (config.MERIT() < 0 || config.MERIT() >= NUM_MERIT_TYPES) {
+    std::cerr << "MERIT must be 0 (equal), 1 (tasks) or 2 (points)." << std::endl;
+    exit(1);
+  }
+  if (config.RESOURCES() &&
+      (config.RESOURCE_INFLOW() <= 0.0 || config.RESOURCE_OUTFLOW() <= 0.0 ||
+       config.RESOURCE_DIFFUSION() < 0.0 || config.RESOURCE_DIFFUSION() > 0.25 ||
+       config.RESOURCE_UPTAKE() <= 0.0 || config.RESOURCE_UPTAKE() > 1.0)) {
+    std::cerr << "RESOURCE_INFLOW and RESOURCE_OUTFLOW must be above 0, RESOURCE_DIFFUSION between "
+                 "0 and 0.25, and RESOURCE_UPTAKE above 0 and at most 1."
+              << std::endl;
+    exit(1);
+  }
+  if (config.NEIGHBORHOOD() < 0 || config.NEIGHBORHOOD() >= NUM_NEIGHBORHOODS) {
+    std::cerr << "NEIGHBORHOOD must be 0 (Moore) or 1 (von Neumann)." << std::endl;
+    exit(1);
+  }
+  // The initial population is capped at WIDTH() * HEIGHT(), which must fit in an int
+  if (config.WIDTH() <= 0 || config.HEIGHT() <= 0 || config.WIDTH() > INT_MAX / config.HEIGHT()) {
+    std::cerr << "WIDTH and HEIGHT must be above 0, and WIDTH * HEIGHT at most " << INT_MAX << "."
+              << std::endl;
+    exit(1);
+  }
+}
+
+/**
+ * @brief Prints an estimate of the memory each organism needs.
+ *
+ * The estimate covers the organism object, its genome, and its share of the world's per-cell
+ * bookkeeping, so it can be multiplied by the grid size to size jobs.
+ *
+ * @param world A reference to the OrgWorld instance representing the simulation world.
+ */
+template <typename Spec>
+void PrintMemoryReport(OrgWorld<Spec> &world) {
+  const size_t bytes_per_org = world.GetBytesPerOrg();
+  const double total_mib = static_cast<double>(bytes_per_org) * world.GetSize() / (1024.0 * 1024.0);
+  std::cout << "Memory per organism: ~" << bytes_per_org << " bytes ("
+            << world.GetSize() << " cells, ~" << total_mib << " MiB when full)" << std::endl;
+}
+
+/**
+ * @brief The settings that can differ between the runs of one invocation.
+ */
+struct RunParams {
+  int seed;
+  bool reward;
+  // Whether organisms get the XOR instruction as well as NAND
+  bool xor_instruction;
+  int updates;
+  std::string file_name;
+  std::string checkpoint_file;
+  // Whether to continue from checkpoint_file instead of starting fresh
+  bool resume;
+  // Threads each world spreads its organisms over
+  int threads;
+  // Whether to print progress for this run (off when many runs share the console)
+  bool verbose;
+};
+
+/**
+ * @brief Builds the parameters of a single run from the configuration.
+ *
+ * @return RunParams The run described by the config settings and command line.
+ */
+RunParams ParamsFromConfig() {
+  return RunParams{config.SEED(),      config.REWARD(),          config.XOR_INSTRUCTION(),
+                   config.UPDATES(),   config.FILE_NAME(),       config.CHECKPOINT_FILE(),
+                   resume,             config.THREADS(),         true};
+}
+
+/**
+ * @brief Reads how resources flow from the configuration.
+ *
+ * @return ResourceSettings The settings for OrgWorld::EnableResources.
+ */
+ResourceSettings ResourceSettingsFromConfig() {
+  ResourceSettings settings;
+  settings.inflow = config.RESOURCE_INFLOW();
+  settings.outflow = config.RESOURCE_OUTFLOW();
+  settings.diffusion = config.RESOURCE_DIFFUSION();
+  settings.uptake = config.RESOURCE_UPTAKE();
+  return settings;
 }
 
 /**
@@ -44,30 +148,202 @@ void InitializeConfig(int argc, char *argv[]) {
  * configuration. It prepares the world for subsequent simulation steps.
  *
  * @param world A reference to the OrgWorld instance representing the simulation world.
+ * @param params The settings specific to this run.
  */
-void RunWorld(OrgWorld &world) {
-  world.SetupDataFile(config.FILE_NAME()).SetTimingRepeat(10);
-  world.SetReward(config.REWARD());
-  
-  for (int i = 0; i < 3600; i++) {
-    Organism* new_org = new Organism(&world);
-    world.AddOrgAt(new_org, i);
-  }
-  world.Resize(60,60);
-  for (int update = 0; update < config.UPDATES(); update++) {
+template <typename Spec>
+void RunWorld(OrgWorld<Spec> &world, const RunParams &params) {
+  world.SetReward(params.reward);
+  world.SetSeed(params.seed);
+  world.SetThreads(params.threads);
+  world.SetScheduling(std::max(config.CYCLES_PER_ORG(), 0), static_cast<MeritType>(config.MERIT()));
+  world.SetSkipDormant(config.SKIP_DORMANT());
+  if (config.RESOURCES()) {
+    world.EnableResources(ResourceSettingsFromConfig());
+  }
+  const size_t phylogeny_interval = std::max(config.PHYLOGENY_INTERVAL(), 0);
+  if (phylogeny_interval) {
+    world.EnablePhylogeny();
+  }
+  const size_t genotype_interval = std::max(config.GENOTYPE_INTERVAL(), 0);
+  const size_t genotype_top = std::max(config.GENOTYPE_TOP(), 0);
+  const size_t genotype_trace = std::max(config.GENOTYPE_TRACE(), 0);
+  const size_t stats_interval = std::max(config.STATS_INTERVAL(), 0);
+  if (stats_interval && !world.EnableStats(params.file_name + ".stats.jsonl", stats_interval,
+                                          params.resume)) {
+    exit(1);
+  }
+  if (config.REPLAY_LOG() && !world.EnableReplayLog(params.file_name + ".replay")) {
+    exit(1);
+  }
+
+  // A checkpoint replaces the configured size with its own, rebuilding the neighbor table
+  world.SetPopStruct_Grid(config.WIDTH(), config.HEIGHT(),
+                          static_cast<Neighborhood>(config.NEIGHBORHOOD()));
+
+  if (params.resume) {
+    if (!world.LoadCheckpoint(params.checkpoint_file)) {
+      exit(1);
+    }
+    if (params.verbose) {
+      std::cout << "Resuming from update " << world.GetUpdate() << std::endl;
+    }
+  } else {
+    const int initial_pop = std::min(config.INITIAL_POP(), config.WIDTH() * config.HEIGHT());
+    for (int i = 0; i < initial_pop; i++) {
+      Organism<Spec>* new_org = new Organism<Spec>(&world, i);
+      world.AddOrgAt(new_org, i);
+    }
+  }
+
+  // emp::DataFile cannot pick up where an earlier file left off, so resumed runs always
+  // write through the census file, which keeps the rows from before the checkpoint
+  const size_t data_interval = 10;
+  if (config.BINARY_DATA() || config.ASYNC_DATA() || params.resume) {
+    world.SetupCensusFile(params.file_name, config.BINARY_DATA(), config.ASYNC_DATA(),
+                          world.GetUpdate(), data_interval);
+  } else {
+    world.SetupDataFile(params.file_name, data_interval);
+  }
+
+  if (params.verbose) {
+    PrintMemoryReport(world);
+  }
+  const size_t checkpoint_interval = std::max(config.CHECKPOINT_INTERVAL(), 0);
+  while (world.GetUpdate() < static_cast<size_t>(params.updates)) {
     world.Update();
+    if (checkpoint_interval && world.GetUpdate() % checkpoint_interval == 0) {
+      world.SaveCheckpoint(params.checkpoint_file);
+    }
+    if (phylogeny_interval && world.GetUpdate() % phylogeny_interval == 0) {
+      world.SavePhylogeny(params.file_name + ".phylogeny" + std::to_string(world.GetUpdate()) + ".csv");
+    }
+    if (genotype_interval && world.GetUpdate() % genotype_interval == 0) {
+      world.SaveGenotypes(params.file_name + ".genotypes" + std::to_string(world.GetUpdate()) + ".txt",
+                          genotype_top, genotype_trace);
+    }
+  }
+  if (params.verbose) {
+    std::cout << "Distinct genomes at update " << world.GetUpdate() << ": "
+              << world.GetGenomes().GetNumGenomes() << std::endl;
+    PrintMemoryReport(world);
+    if (stats_interval) {
+      world.PrintStatsSummary(std::cout);
+    }
   }
 }
 
-// This is the main function for the NATIVE version of this project.
-int main(int argc, char *argv[]) {
-  InitializeConfig(argc, argv);
-
-  emp::Random random(config.SEED());
-  OrgWorld world(random);
+/**
+ * @brief Creates an independent world for a run and runs it to completion.
+ *
+ * Each run gets its own emp::Random. sgpl::tlrand is thread-local, so reseeding it here only
+ * affects the thread the run executes on, and runs on different threads never share state.
+ *
+ * @tparam Spec The instruction set the run's organisms use.
+ * @param params The settings of the run.
+ */
+template <typename Spec>
+void RunTreatment(const RunParams &params) {
+  emp::Random random(params.seed);
+  OrgWorld<Spec> world(random);
   // Some SignalGP-Lite functionality uses its own emp::Random instance
   // so it's important to set that seed too when the main Random is created
   sgpl::tlrand.Get().ResetSeed(2);
 
-  RunWorld(world);
-}
\ No newline at end of file
+  RunWorld(world, params);
+}
+
+/**
+ * @brief Runs a job with the world type for its instruction set.
+ *
+ * This is the only place the instruction set is chosen; everything below it is compiled
+ * separately for each set.
+ *
+ * @param params The settings of the run.
+ */
+void RunJob(const RunParams &params) {
+  if (params.xor_instruction) {
+    RunTreatment<NandXorSpec>(params);
+  } else {
+    RunTreatment<NandSpec>(params);
+  }
+}
+
+/**
+ * @brief Reads the list of runs for batch mode.
+ *
+ * Each non-empty line that does not start with '#' describes one run as
+ * `SEED REWARD XOR UPDATES [FILE_NAME]`, where XOR is 1 if organisms get the XOR
+ * instruction. Without a file name, output goes to DataFileS<SEED>R<REWARD>X<XOR>.dat.
+ * Every other setting is shared by all runs.
+ *
+ * @param filename The path of the batch file.
+ * @return emp::vector<RunParams> The runs, in file order.
+ */
+emp::vector<RunParams> ReadBatchFile(const std::string &filename) {
+  std::ifstream file(filename);
+  if (!file) {
+    std::cerr << "Could not open batch file " << filename << std::endl;
+    exit(1);
+  }
+  emp::vector<RunParams> jobs;
+  std::string line;
+  while (std::getline(file, line)) {
+    std::istringstream fields(line);
+    RunParams job = ParamsFromConfig();
+    if (!(fields >> job.seed)) {
+      continue; // blank line or comment
+    }
+    if (!(fields >> job.reward >> job.xor_instruction >> job.updates)) {
+      std::cerr << "Bad batch line (expected SEED REWARD XOR UPDATES [FILE_NAME]): " << line << std::endl;
+      exit(1);
+    }
+    if (!(fields >> job.file_name)) {
+      job.file_name = "DataFileS" + std::to_string(job.seed) + "R" + std::to_string(job.reward) +
+                      "X" + std::to_string(job.xor_instruction) + ".dat";
+    }
+    job.checkpoint_file = job.file_name + ".checkpoint";
+    // A resumed batch restarts runs that never reached a checkpoint
+    job.resume = resume && std::ifstream(job.checkpoint_file).good();
+    job.threads = 1;
+    job.verbose = false;
+    jobs.push_back(job);
+  }
+  return jobs;
+}
+
+/**
+ * @brief Runs every job in the batch file concurrently, one world per thread at a time.
+ *
+ * Threads take the next unstarted job as soon as they finish one, so a batch with more jobs
+ * than threads keeps every thread busy until the queue runs dry.
+ */
+void RunBatch() {
+  const emp::vector<RunParams> jobs = ReadBatchFile(config.BATCH_FILE());
+  size_t num_threads = config.BATCH_THREADS() > 0 ? config.BATCH_THREADS()
+                                                  : std::thread::hardware_concurrency();
+  num_threads = std::max<size_t>(1, std::min(num_threads, jobs.size()));
+  std::cout << "Running " << jobs.size() << " jobs on " << num_threads << " threads" << std::endl;
+
+  std::atomic<size_t> next_job{0};
+  std::mutex output_mutex;
+  ThreadPool pool(num_threads);
+  pool.Run([&](size_t) {
+    for (size_t job = next_job++; job < jobs.size(); job = next_job++) {
+      RunJob(jobs[job]);
+      std::lock_guard<std::mutex> lock(output_mutex);
+      std::cout << "Finished SEED " << jobs[job].seed << " REWARD " << jobs[job].reward
+                << " XOR " << jobs[job].xor_instruction << " -> " << jobs[job].file_name << std::endl;
+    }
+  });
+}
+
+// This is the main function for the NATIVE version of this project.
+int main(int argc, char *argv[]) {
+  InitializeConfig(argc, argv);
+
+  if (!config.BATCH_FILE().empty()) {
+    RunBatch();
+  } else {
+    RunJob(ParamsFromConfig());
+  }
+}
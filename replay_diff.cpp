@@ -0,0 +1,98 @@
+// Compile with `c++ -std=c++17 -O2 replay_diff.cpp -o replay_diff`
+//
+// Compares the replay logs of two runs written with REPLAY_LOG set and
+// reports the first update at which they differ, and which random number
+// generators and cells differ at that update.
+
+#include <iostream>
+
+#include "ReplayLog.h"
+
+/**
+ * Input: A cell index and the grid width
+ *
+ * Output: None
+ *
+ * Purpose: Prints the cell with its grid coordinates.
+ */
+void PrintCell(size_t cell, uint32_t width) {
+  std::cout << "cell " << cell;
+  if (width) {
+    std::cout << " (x " << cell % width << ", y " << cell / width << ")";
+  }
+}
+
+int main(int argc, char *argv[]) {
+  if (argc != 3) {
+    std::cerr << "Usage: " << argv[0] << " <replay log> <replay log>" << std::endl;
+    return 1;
+  }
+  ReplayLogReader first(argv[1]), second(argv[2]);
+  for (const ReplayLogReader *reader : {&first, &second}) {
+    if (!reader->IsValid()) {
+      std::cerr << (reader == &first ? argv[1] : argv[2]) << " is not a valid replay log."
+                << std::endl;
+      return 1;
+    }
+  }
+
+  // The logs are read in step, so only the current record of each is ever in memory
+  ReplayRecord a, b;
+  size_t num_records = 0;
+  bool has_a = first.Next(a), has_b = second.Next(b);
+  for (; has_a && has_b; num_records++, has_a = first.Next(a), has_b = second.Next(b)) {
+    if (a.update != b.update) {
+      std::cout << "Record " << num_records << " is for update " << a.update << " in " << argv[1]
+                << " but update " << b.update << " in " << argv[2] << std::endl;
+      return 2;
+    }
+    const bool world_random = a.world_random != b.world_random;
+    const bool sgpl_random = a.sgpl_random != b.sgpl_random;
+    if (!world_random && !sgpl_random && a.population == b.population) {
+      continue;
+    }
+
+    std::cout << "Runs diverge after update " << a.update << ":" << std::endl;
+    if (world_random) {
+      std::cout << "  world random number generator state differs" << std::endl;
+    }
+    if (sgpl_random) {
+      std::cout << "  sgpl::tlrand state differs" << std::endl;
+    }
+    if (a.cells.size() != b.cells.size()) {
+      std::cout << "  worlds have " << a.cells.size() << " and " << b.cells.size()
+                << " cells" << std::endl;
+      return 2;
+    }
+    size_t num_diverged = 0;
+    for (size_t cell = 0; cell < a.cells.size(); cell++) {
+      if (a.cells[cell] == b.cells[cell]) {
+        continue;
+      }
+      if (num_diverged == 0) {
+        std::cout << "  first differing ";
+        PrintCell(cell, a.width);
+        if (!a.cells[cell] || !b.cells[cell]) {
+          std::cout << ", empty in " << (a.cells[cell] ? argv[2] : argv[1]);
+        }
+        std::cout << std::endl;
+      }
+      num_diverged++;
+    }
+    std::cout << "  " << num_diverged << " of " << a.cells.size() << " cells differ"
+              << std::endl;
+    return 2;
+  }
+
+  std::cout << "Runs match for all " << num_records << " updates in both logs";
+  if (has_a || has_b) {
+    ReplayLogReader &longer = has_a ? first : second;
+    ReplayRecord &record = has_a ? a : b;
+    size_t num_extra = 0;
+    do {
+      num_extra++;
+    } while (longer.Next(record));
+    std::cout << "; " << (has_a ? argv[1] : argv[2]) << " continues for " << num_extra << " more";
+  }
+  std::cout << std::endl;
+}
@@ -0,0 +1,239 @@
+// Compile and run with `./compile-run-tests.sh`, or
+// `c++ -O2 -std=c++17 -pthread -Isignalgp-lite/third-party/Empirical/include/ -Isignalgp-lite/include/ tests.cpp -o tests`
+//
+// Checks of simulation behavior that the benchmarks and replay logs do not
+// cover on their own. Each failed check is printed, and the exit status is the
+// number of failures.
+
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+
+#include "ReplayLog.h"
+#include "World.h"
+
+using Spec = NandXorSpec;
+
+size_t failures = 0;
+
+/**
+ * @brief Records a failed check.
+ *
+ * @param passed Whether the check passed.
+ * @param what What was checked, printed if it failed.
+ */
+void Check(bool passed, const std::string &what) {
+  if (!passed) {
+    std::cout << "FAILED: " << what << std::endl;
+    failures++;
+  }
+}
+
+/**
+ * @brief Reads a whole file, for comparing files byte for byte.
+ */
+std::string ReadFile(const std::string &filename) {
+  std::ifstream in(filename, std::ios::binary);
+  return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+/**
+ * @brief Configures a world the same way before seeding it or resuming it.
+ */
+void SetupWorld(OrgWorld<Spec> &world, bool resources) {
+  world.SetReward(true);
+  world.SetSeed(7);
+  world.SetThreads(2);
+  world.SetScheduling(10, MERIT_TASKS);
+  if (resources) {
+    world.EnableResources(ResourceSettings{});
+  }
+  world.SetPopStruct_Grid(30, 30);
+  world.SetupCensus();
+}
+
+/**
+ * @brief A run resumed from a checkpoint at update N follows the same trajectory as a run
+ * that was never interrupted: the replay log records after N match, and so does the
+ * final checkpoint.
+ */
+void TestCheckpointResume(bool resources) {
+  const std::string name = std::string("checkpoint resume") + (resources ? " with resources" : "");
+  const size_t checkpoint_update = 40, final_update = 100;
+  {
+    emp::Random random(7);
+    OrgWorld<Spec> world(random);
+    SetupWorld(world, resources);
+    world.EnableReplayLog("test_uninterrupted.replay");
+    for (size_t i = 0; i < 900; i++) {
+      world.AddOrgAt(emp::NewPtr<Organism<Spec>>(&world, i), i);
+    }
+    while (world.GetUpdate() < final_update) {
+      world.Update();
+      if (world.GetUpdate() == checkpoint_update) {
+        world.SaveCheckpoint("test.checkpoint");
+      }
+    }
+    world.SaveCheckpoint("test_uninterrupted.checkpoint");
+  }
+  {
+    // A different seed, so nothing matches unless the checkpoint restores it
+    emp::Random random(99);
+    OrgWorld<Spec> world(random);
+    SetupWorld(world, resources);
+    world.EnableReplayLog("test_resumed.replay");
+    Check(world.LoadCheckpoint("test.checkpoint"), name + ": checkpoint loads");
+    while (world.GetUpdate() < final_update) {
+      world.Update();
+    }
+    world.SaveCheckpoint("test_resumed.checkpoint");
+  }
+
+  ReplayLogReader uninterrupted("test_uninterrupted.replay"), resumed("test_resumed.replay");
+  ReplayRecord expected, actual;
+  size_t compared = 0;
+  while (uninterrupted.Next(expected)) {
+    if (expected.update <= checkpoint_update) {
+      continue;
+    }
+    if (!resumed.Next(actual)) {
+      break;
+    }
+    compared++;
+    Check(expected.update == actual.update && expected.world_random == actual.world_random &&
+              expected.sgpl_random == actual.sgpl_random && expected.cells == actual.cells,
+          name + ": replay record for update " + std::to_string(expected.update) + " matches");
+  }
+  Check(compared == final_update - checkpoint_update,
+        name + ": resumed run logs every update after the checkpoint");
+  Check(ReadFile("test_uninterrupted.checkpoint") == ReadFile("test_resumed.checkpoint"),
+        name + ": final checkpoints are identical");
+
+  for (const char *filename : {"test.checkpoint", "test_uninterrupted.checkpoint",
+                               "test_resumed.checkpoint", "test_uninterrupted.replay",
+                               "test_resumed.replay"}) {
+    std::remove(filename);
+  }
+}
+
+/**
+ * @brief Merit scheduling gives each cell its expected share of the update's cycles:
+ * budgets add up to exactly cycles_per_org per organism, each is its share rounded
+ * down or up, and averaged over many updates each matches total * merit / total merit.
+ */
+void TestCycleBudgets() {
+  const std::string name = "cycle budgets";
+  const uint32_t cycles_per_org = 10;
+  emp::Random random(7);
+  OrgWorld<Spec> world(random);
+  SetupWorld(world, false);
+  world.SetScheduling(cycles_per_org, MERIT_POINTS);
+  for (size_t i = 0; i < 900; i++) {
+    world.AddOrgAt(emp::NewPtr<Organism<Spec>>(&world, i), i);
+  }
+  // Let points spread out so the merits differ
+  while (world.GetUpdate() < 30) {
+    world.Update();
+  }
+
+  emp::vector<double> shares(world.GetSize(), 0.0);
+  size_t num_orgs = 0;
+  double total_merit = 0.0;
+  for (size_t i = 0; i < world.GetSize(); i++) {
+    if (world.IsOccupied(i)) {
+      total_merit += world.GetMerit(i);
+      num_orgs++;
+    }
+  }
+  const uint64_t total_cycles = num_orgs * cycles_per_org;
+  for (size_t i = 0; i < world.GetSize(); i++) {
+    if (world.IsOccupied(i)) {
+      shares[i] = total_cycles * world.GetMerit(i) / total_merit;
+    }
+  }
+
+  const size_t repeats = 2000;
+  emp::vector<double> mean_budgets(world.GetSize(), 0.0);
+  for (size_t r = 0; r < repeats; r++) {
+    world.AssignCycleBudgets();
+    const emp::vector<uint32_t> &budgets = world.GetCycleBudgets();
+    uint64_t assigned = 0;
+    bool within_one = true;
+    for (size_t i = 0; i < budgets.size(); i++) {
+      assigned += budgets[i];
+      within_one &= budgets[i] == std::floor(shares[i]) || budgets[i] == std::ceil(shares[i]);
+      mean_budgets[i] += static_cast<double>(budgets[i]) / repeats;
+    }
+    Check(assigned == total_cycles, name + ": budgets add up to the update's total");
+    Check(within_one, name + ": every budget is its share rounded down or up");
+  }
+
+  // Each mean has a standard deviation of at most 0.5 / sqrt(repeats), about 0.011
+  bool means_match = true;
+  for (size_t i = 0; i < shares.size(); i++) {
+    means_match &= std::abs(mean_budgets[i] - shares[i]) < 0.06;
+  }
+  Check(means_match, name + ": mean budgets match merit / total merit");
+}
+
+/**
+ * A single cell whose resources can be set up directly, for checking payments.
+ */
+class ResourceCell : public OrgWorldBase {
+public:
+  explicit ResourceCell(const ResourceSettings &settings) {
+    states.Resize(1);
+    reproduce_requests.assign(1, 0);
+    resources = emp::NewPtr<ResourceGrid>(settings);
+    resources->Resize(1, 1);
+  }
+  ~ResourceCell() { resources.Delete(); }
+};
+
+/**
+ * @brief A task whose resource is used up still pays the failure points, never less.
+ * With an uptake of 1 the first output uses up each of its tasks' resources entirely,
+ * so the same output again pays as if none of its tasks were performed.
+ */
+void TestDepletedResources(bool reward) {
+  const std::string name = std::string("depleted resources, reward ") + (reward ? "all" : "none");
+  ResourceSettings settings;
+  settings.uptake = 1.0f;
+  ResourceCell world(settings);
+  world.SetReward(reward);
+  OrgState state;
+  state.world = &world;
+  state.store = &world.GetStates();
+  state.cell = 0;
+
+  // With an all-zero input window, all ones performs NOT, NAND, ORN, NOR and EQU
+  const uint32_t output = ~0u;
+  const uint32_t done = world.GetStates().MatchOutput(0, output);
+  Check(done != 0, name + ": output performs tasks");
+  const double *points_for = reward ? TASK_POINTS.all : TASK_POINTS.equ_only;
+
+  world.CheckOutput(reward, output, state);
+  Check(state.GetPoints() == points_for[done], name + ": full resources pay the full reward");
+  const double before = state.GetPoints();
+  world.CheckOutput(reward, output, state);
+  Check(state.GetPoints() - before == points_for[0],
+        name + ": depleted resources pay the failure points");
+}
+
+int main() {
+  TestCheckpointResume(false);
+  TestCheckpointResume(true);
+  TestCycleBudgets();
+  TestDepletedResources(true);
+  TestDepletedResources(false);
+
+  if (failures) {
+    std::cout << failures << " checks failed" << std::endl;
+  } else {
+    std::cout << "All checks passed" << std::endl;
+  }
+  return failures;
+}
@@ -1,6 +1,11 @@
 #define UIT_VENDORIZE_EMP
 #define UIT_SUPPRESS_MACRO_INSEEP_WARNINGS
 
+#include <array>
+#include <vector>
+
+#include <emscripten.h>
+
 #include "emp/math/Random.hpp"
 #include "emp/web/Animate.hpp"
 #include "emp/web/Document.hpp"
@@ -19,18 +24,40 @@ emp::web::Document buttons("buttons");
 emp::web::Document text("text");
 MyConfigType config;
 
+/**
+ * @brief Packs a color into a pixel of an RGBA buffer, whose bytes are in the order red,
+ * green, blue, alpha in memory.
+ */
+constexpr uint32_t Rgba(uint32_t r, uint32_t g, uint32_t b) {
+    return r | (g << 8) | (b << 16) | 0xFF000000u;
+}
+
+constexpr uint32_t BLACK_PIXEL = Rgba(0, 0, 0);
+constexpr uint32_t WHITE_PIXEL = Rgba(255, 255, 255);
+// Display color of each task (cyan, purple, blue, teal, green, yellow, orange, red, brown),
+// indexed by TaskId
+constexpr uint32_t TASK_PIXELS[NUM_TASKS] = {
+    Rgba(0, 255, 255), Rgba(128, 0, 128), Rgba(0, 0, 255),   Rgba(0, 128, 128), Rgba(0, 128, 0),
+    Rgba(255, 255, 0), Rgba(255, 165, 0), Rgba(255, 0, 0), Rgba(165, 42, 42)};
+
 class AEAnimator : public emp::web::Animate {
 
-    // arena width and height
-    const int num_h_boxes = 60;
-    const int num_w_boxes = 60;
-    const double RECT_SIDE = 5;
-    const double width{num_w_boxes * RECT_SIDE};
-    const double height{num_h_boxes * RECT_SIDE};
+    // arena width and height, set from the config once it has been read
+    int num_h_boxes = config.HEIGHT();
+    int num_w_boxes = config.WIDTH();
+    double RECT_SIDE = 5;
+    double width{num_w_boxes * RECT_SIDE};
+    double height{num_h_boxes * RECT_SIDE};
     emp::Random random{config.SEED()};
-    OrgWorld world{random};
+    // Only the world for the configured instruction set is created
+    emp::Ptr<OrgWorld<NandSpec>> nand_world;
+    emp::Ptr<OrgWorld<NandXorSpec>> nand_xor_world;
 
     emp::web::Canvas canvas{width, height, "canvas"};
+    // One pixel per cell, blitted to the canvas and scaled up once per frame
+    std::vector<uint32_t> pixels;
+    // The pixel for every completed-task bitmask
+    std::array<uint32_t, 1 << NUM_TASKS> task_palette;
 
     public:
 
@@ -45,90 +72,172 @@ class AEAnimator : public emp::web::Animate {
         emp::prefab::ConfigPanel config_panel(config);
         config_panel.ExcludeSetting("FILE_NAME");
         config_panel.ExcludeSetting("UPDATES");
+        config_panel.ExcludeSetting("THREADS");
+        config_panel.ExcludeSetting("BINARY_DATA");
+        config_panel.ExcludeSetting("ASYNC_DATA");
+        config_panel.ExcludeSetting("CHECKPOINT_INTERVAL");
+        config_panel.ExcludeSetting("CHECKPOINT_FILE");
+        config_panel.ExcludeSetting("PHYLOGENY_INTERVAL");
+        config_panel.ExcludeSetting("GENOTYPE_INTERVAL");
+        config_panel.ExcludeSetting("GENOTYPE_TOP");
+        config_panel.ExcludeSetting("GENOTYPE_TRACE");
+        config_panel.ExcludeSetting("STATS_INTERVAL");
+        config_panel.ExcludeSetting("REPLAY_LOG");
+        config_panel.ExcludeSetting("BATCH_FILE");
+        config_panel.ExcludeSetting("BATCH_THREADS");
         settings << config_panel;
         random.ResetSeed(config.SEED());
+
+        // size the arena from the config, shrinking cells so large grids still fit
+        num_h_boxes = config.HEIGHT();
+        num_w_boxes = config.WIDTH();
+        RECT_SIDE = std::max(1.0, 300.0 / std::max(num_w_boxes, num_h_boxes));
+        width = num_w_boxes * RECT_SIDE;
+        height = num_h_boxes * RECT_SIDE;
+        canvas.SetSize(width, height);
+        pixels.assign(num_w_boxes * num_h_boxes, WHITE_PIXEL);
+        for (uint32_t tasks_done = 0; tasks_done < task_palette.size(); tasks_done++) {
+            task_palette[tasks_done] = CellPixel(tasks_done);
+        }
     
         // shove canvas into the div
         // along with a control button
         doc << canvas;
         buttons << GetToggleButton("Toggle");
         buttons << GetStepButton("Step");
-        text << "This is a visual representation of a world containing 3600 organisms in a 60 x 60\
+        text << "This is a visual representation of a world containing " << num_w_boxes * num_h_boxes
+             << " cells in a " << num_w_boxes << " x " << num_h_boxes << "\
         grid, in which the organisms can evolve to perform logic tasks of increasing complexity. A black\
         square represents an organism that has not completed any task. If an organism has complete a task,\
         the color of its most difficult task will be shown. The colors, in ascending order of difficulty, are:\
         NOT - brown, NAND - red, AND - orange, ORN - yellow, OR - green, ANDN - teal, NOR - blue, XOR - purple,\
         EQU - cyan. There are two experiments that can be performed. One uses the 'Reward' slider, which\
         allows you to switch rewards from 'on' (where more complex tasks are rewarded with more points), and 'off'\
-        (where all tasks are rewarded equally). The other experiment cannot be carried out using config sliders,\
-        since the changes necessary must be evaluated at compile time rather than at runtime. In the 'Instructions.h'\
-        file, the xor_bool can be manipulated to allow organisms to either only have the NAND instruction built into\
-        their genomes or to have both NAND and XOR built in. Change the seed slider to run multiple trials for the\
-        same treatment.";
+        (where all tasks are rewarded equally). The other uses the 'Xor instruction' setting, which allows\
+        organisms to either only have the NAND instruction built into their genomes or to have both NAND and XOR\
+        built in. Change the seed slider to run multiple trials for the same treatment.";
 
-        world.Resize(num_h_boxes,num_w_boxes);
-        world.SetPopStruct_Grid(num_w_boxes, num_h_boxes);
+        if (config.XOR_INSTRUCTION()) {
+            nand_xor_world.New(random);
+            SetupWorld(*nand_xor_world);
+        } else {
+            nand_world.New(random);
+            SetupWorld(*nand_world);
+        }
+    }
 
-        for (int i = 0; i < 3600; i++) {
-            Organism* new_org = new Organism(&world);
+    ~AEAnimator() {
+        if (nand_world) nand_world.Delete();
+        if (nand_xor_world) nand_xor_world.Delete();
+    }
+
+    /**
+     * @brief Sizes the world to the arena and fills it with the initial population.
+     *
+     * @param world The world for the configured instruction set.
+     */
+    template <typename Spec>
+    void SetupWorld(OrgWorld<Spec> &world) {
+        world.SetSeed(config.SEED());
+        world.SetReward(config.REWARD());
+        const int merit = std::clamp(config.MERIT(), 0, NUM_MERIT_TYPES - 1);
+        world.SetScheduling(std::max(config.CYCLES_PER_ORG(), 0), static_cast<MeritType>(merit));
+        world.SetSkipDormant(config.SKIP_DORMANT());
+        if (config.RESOURCES()) {
+            ResourceSettings resource_settings;
+            resource_settings.inflow = std::max(config.RESOURCE_INFLOW(), 1e-6);
+            resource_settings.outflow = std::max(config.RESOURCE_OUTFLOW(), 1e-6);
+            resource_settings.diffusion = std::clamp(config.RESOURCE_DIFFUSION(), 0.0, 0.25);
+            resource_settings.uptake = std::clamp(config.RESOURCE_UPTAKE(), 1e-6, 1.0);
+            world.EnableResources(resource_settings);
+        }
+        const int neighborhood = std::clamp(config.NEIGHBORHOOD(), 0, NUM_NEIGHBORHOODS - 1);
+        world.SetPopStruct_Grid(num_w_boxes, num_h_boxes, static_cast<Neighborhood>(neighborhood));
+
+        const int initial_pop = std::min(config.INITIAL_POP(), num_w_boxes * num_h_boxes);
+        for (int i = 0; i < initial_pop; i++) {
+            Organism<Spec>* new_org = new Organism<Spec>(&world, i);
             world.AddOrgAt(new_org, i);
         }
     }
 
     /**
-     * @brief Renders a cell on the canvas based on the organism's current state.
+     * @brief Chooses the color of a cell based on the organism's completed tasks.
      *
-     * Depending on the flags set in cur_state, this function draws a cell with a color that represents
-     * the state of an organism at the given grid position (x, y). The colors correspond to different properties
-     * (i.e. squared is green, doubled is red, etc.). If no flag is set, a black rectangle is drawn. Called by
-     * DoFrame.
+     * The cell is drawn in the color of the most difficult task the organism has completed
+     * (tasks are ordered from most to least difficult by TaskId). If no task has been
+     * completed, it is drawn black. Only used to fill task_palette.
      *
-     * @param cur_state The current state of the organism containing flags such as hasSquared, hasDoubled, etc.
-     * @param x The x-coordinate on the grid.
-     * @param y The y-coordinate on the grid.
+     * @param tasks_done The bitmask of tasks the organism has completed.
+     * @return uint32_t The cell's pixel.
      */
-    void CheckState(OrgState cur_state, int x, int y) {
-        if (cur_state.doneEQU) {
-            canvas.Rect(x * RECT_SIDE, y * RECT_SIDE, RECT_SIDE, RECT_SIDE, "cyan", "black");
-        } else if (cur_state.doneXOR) {
-            canvas.Rect(x * RECT_SIDE, y * RECT_SIDE, RECT_SIDE, RECT_SIDE, "purple", "black");
-        } else if (cur_state.doneNOR) {
-            canvas.Rect(x * RECT_SIDE, y * RECT_SIDE, RECT_SIDE, RECT_SIDE, "blue", "black");
-        } else if (cur_state.doneANDN) {
-            canvas.Rect(x * RECT_SIDE, y * RECT_SIDE, RECT_SIDE, RECT_SIDE, "teal", "black");
-        } else if (cur_state.doneOR) {
-            canvas.Rect(x * RECT_SIDE, y * RECT_SIDE, RECT_SIDE, RECT_SIDE, "green", "black");
-        } else if (cur_state.doneORN) {
-            canvas.Rect(x * RECT_SIDE, y * RECT_SIDE, RECT_SIDE, RECT_SIDE, "yellow", "black");
-        } else if (cur_state.doneAND) {
-            canvas.Rect(x * RECT_SIDE, y * RECT_SIDE, RECT_SIDE, RECT_SIDE, "orange", "black");
-        } else if (cur_state.doneNAND) {
-            canvas.Rect(x * RECT_SIDE, y * RECT_SIDE, RECT_SIDE, RECT_SIDE, "red", "black");
-        } else if (cur_state.doneNOT) {
-            canvas.Rect(x * RECT_SIDE, y * RECT_SIDE, RECT_SIDE, RECT_SIDE, "brown", "black");
-        } else {
-            canvas.Rect(x * RECT_SIDE, y * RECT_SIDE, RECT_SIDE, RECT_SIDE, "black", "black");
+    static uint32_t CellPixel(uint32_t tasks_done) {
+        for (size_t task = 0; task < NUM_TASKS; task++) {
+            if ((tasks_done >> task) & 1) {
+                return TASK_PIXELS[task];
+            }
         }
+        return BLACK_PIXEL;
+    }
+
+    /**
+     * @brief Copies the pixel buffer onto the canvas.
+     *
+     * The buffer is put into an offscreen canvas the size of the grid with a single
+     * putImageData, which is then scaled onto the visible canvas without smoothing.
+     */
+    void DrawPixels() {
+        EM_ASM({
+            const canvas = document.getElementById(UTF8ToString($0));
+            if (!canvas) return;
+            let buffer = canvas.pixel_buffer;
+            if (!buffer || buffer.width != $2 || buffer.height != $3) {
+                buffer = document.createElement('canvas');
+                buffer.width = $2;
+                buffer.height = $3;
+                canvas.pixel_buffer = buffer;
+            }
+            const image = new ImageData(new Uint8ClampedArray(HEAPU8.buffer, $1, $2 * $3 * 4), $2, $3);
+            buffer.getContext('2d').putImageData(image, 0, 0);
+            const ctx = canvas.getContext('2d');
+            ctx.imageSmoothingEnabled = false;
+            ctx.drawImage(buffer, 0, 0, canvas.width, canvas.height);
+        }, canvas.GetID().c_str(), pixels.data(), num_w_boxes, num_h_boxes);
     }
 
     /**
      * @brief Executes a grid update; overrides the base DoFrame function.
      *
      * This function is responsible for updating the state of the animation for each frame.
-     * Iterates through each cell individually to check what color it should be.
      */
     void DoFrame() override {
-        canvas.Clear();
-        world.Update();
-
-        int org_num = 0;
-        for (int x = 0; x < num_w_boxes; x++){
-            for (int y = 0; y < num_h_boxes; y++) {
-                OrgState cur_state = world.GetPopulation()[org_num]->getCPU().state;
-                CheckState(cur_state, x, y);
-                org_num++;
-            }
+        if (nand_xor_world) {
+            UpdateAndDraw(*nand_xor_world);
+        } else {
+            UpdateAndDraw(*nand_world);
+        }
+    }
+
+    /**
+     * @brief Runs UPDATES_PER_FRAME updates of the world, then redraws it.
+     *
+     * Each cell's pixel is looked up from its task bitmask in the world's state store,
+     * empty cells are white, and the whole grid is drawn with DrawPixels().
+     *
+     * @param world The world for the configured instruction set.
+     */
+    template <typename Spec>
+    void UpdateAndDraw(OrgWorld<Spec> &world) {
+        const int updates = std::max(config.UPDATES_PER_FRAME(), 1);
+        for (int i = 0; i < updates; i++) {
+            world.Update();
+        }
+
+        const std::vector<uint32_t> &tasks_done = world.GetStates().tasks_done;
+        for (size_t cell = 0; cell < pixels.size(); cell++) {
+            pixels[cell] = world.IsOccupied(cell) ? task_palette[tasks_done[cell]] : WHITE_PIXEL;
         }
+        DrawPixels();
     }
 };
 